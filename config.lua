@@ -248,6 +248,11 @@ max_deepness_of_chain_of_containers = 500
 --should OTServ bind only global IP address ?
 bind_only_global_address = false
 
+-- Server saves snapshot this many online players per tick and write them on a background thread
+save_players_per_tick = 25
+-- Delay between two of those ticks in ms (1000 = 1 second)
+save_tick_interval = 50
+
 -- How many items can be stacked in a single tile (all type of tiles)(client side)? DO NOT CHANGE IT UNLESS THAT YOU KNOW WHAT YOU ARE DOING
 max_stack_size = 1000
 
@@ -157,7 +157,7 @@ bool Combat::getMinMaxValues(Creature* creature, Creature* target, int32_t& min,
 }
 
 void Combat::getCombatArea(const Position& centerPos, const Position& targetPos, const AreaCombat* area,
-                           std::list<Tile*>& list)
+                           CombatTileList& list)
 {
 	if (area)
 	{
@@ -990,7 +990,18 @@ void Combat::addDistanceEffect(Creature* caster, const Position& fromPos,
 void Combat::CombatFunc(Creature* caster, const Position& pos,
                         const AreaCombat* area, const CombatParams& params, COMBATFUNC func, void* data)
 {
-	std::list<Tile*> tileList;
+	// the tile lists are reused between casts, script callbacks can start
+	// another area combat so every nesting level gets its own list
+	static std::vector<CombatTileList*> tileListPool;
+	static uint32_t tileListDepth = 0;
+
+	if (tileListDepth >= tileListPool.size())
+	{
+		tileListPool.push_back(new CombatTileList());
+	}
+
+	CombatTileList& tileList = *tileListPool[tileListDepth++];
+	tileList.clear();
 
 	if (caster)
 	{
@@ -1007,7 +1018,7 @@ void Combat::CombatFunc(Creature* caster, const Position& pos,
 	uint32_t diff;
 
 	//calculate the max viewable range
-	for (std::list<Tile*>::iterator it = tileList.begin(); it != tileList.end(); ++it)
+	for (CombatTileList::iterator it = tileList.begin(); it != tileList.end(); ++it)
 	{
 		diff = std::abs((*it)->getPosition().x - pos.x);
 
@@ -1027,7 +1038,7 @@ void Combat::CombatFunc(Creature* caster, const Position& pos,
 	g_game.getSpectators(list, pos, false, true, maxX + Map::maxViewportX, maxX + Map::maxViewportX,
 	                     maxY + Map::maxViewportY, maxY + Map::maxViewportY);
 
-	for (std::list<Tile*>::iterator it = tileList.begin(); it != tileList.end(); ++it)
+	for (CombatTileList::iterator it = tileList.begin(); it != tileList.end(); ++it)
 	{
 		Tile* iter_tile = *it;
 		bool bContinue = true;
@@ -1081,6 +1092,8 @@ void Combat::CombatFunc(Creature* caster, const Position& pos,
 		}
 	}
 
+	tileList.clear();
+	--tileListDepth;
 	postCombatEffects(caster, pos, params);
 }
 
@@ -1537,6 +1550,8 @@ MatrixArea::MatrixArea(const MatrixArea& rhs)
 			data_[row][col] = rhs.data_[row][col];
 		}
 	}
+
+	offsets = rhs.offsets;
 }
 
 MatrixArea::~MatrixArea()
@@ -1591,10 +1606,39 @@ bool* MatrixArea::operator[](const uint32_t& i)
 	return data_[i];
 }
 
+void MatrixArea::updateOffsets()
+{
+	offsets.clear();
+
+	for (uint32_t row = 0; row < rows; ++row)
+	{
+		for (uint32_t col = 0; col < cols; ++col)
+		{
+			if (data_[row][col])
+			{
+				AreaOffset offset;
+				offset.x = (int16_t)((int32_t)col - (int32_t)centerX);
+				offset.y = (int16_t)((int32_t)row - (int32_t)centerY);
+				offsets.push_back(offset);
+			}
+		}
+	}
+}
+
+const AreaOffsetVector& MatrixArea::getOffsets() const
+{
+	return offsets;
+}
+
 //**********************************************************
 AreaCombat::AreaCombat()
 {
 	hasExtArea = false;
+
+	for (uint32_t dir = 0; dir < AREACOMBAT_DIRECTIONS; ++dir)
+	{
+		areas[dir] = NULL;
+	}
 }
 
 AreaCombat::~AreaCombat()
@@ -1606,25 +1650,30 @@ AreaCombat::AreaCombat(const AreaCombat& rhs)
 {
 	hasExtArea = rhs.hasExtArea;
 
-	for (AreaCombatMap::const_iterator it = rhs.areas.begin(); it != rhs.areas.end(); ++it)
+	for (uint32_t dir = 0; dir < AREACOMBAT_DIRECTIONS; ++dir)
 	{
-		areas[it->first] = new MatrixArea(*it->second);
+		areas[dir] = (rhs.areas[dir] ? new MatrixArea(*rhs.areas[dir]) : NULL);
 	}
 }
 
 void AreaCombat::clear()
 {
-	for (AreaCombatMap::iterator it = areas.begin(); it != areas.end(); ++it)
+	for (uint32_t dir = 0; dir < AREACOMBAT_DIRECTIONS; ++dir)
 	{
-		delete it->second;
+		delete areas[dir];
+		areas[dir] = NULL;
 	}
+}
 
-	areas.clear();
+void AreaCombat::setArea(const Direction& dir, MatrixArea* area)
+{
+	area->updateOffsets();
+	delete areas[dir];
+	areas[dir] = area;
 }
 
-bool AreaCombat::getList(const Position& centerPos, const Position& targetPos, std::list<Tile*>& list) const
+bool AreaCombat::getList(const Position& centerPos, const Position& targetPos, CombatTileList& list) const
 {
-	Tile* tile = g_game.getTile(targetPos.x, targetPos.y, targetPos.z);
 	const MatrixArea* area = getArea(centerPos, targetPos);
 
 	if (!area)
@@ -1632,47 +1681,33 @@ bool AreaCombat::getList(const Position& centerPos, const Position& targetPos, s
 		return false;
 	}
 
-	int32_t tmpPosX = targetPos.x;
-	int32_t tmpPosY = targetPos.y;
-	int32_t tmpPosZ = targetPos.z;
-	size_t cols = area->getCols();
-	size_t rows = area->getRows();
-	uint32_t centerY, centerX;
-	area->getCenter(centerY, centerX);
-	tmpPosX -= centerX;
-	tmpPosY -= centerY;
+	const AreaOffsetVector& offsets = area->getOffsets();
+	list.reserve(list.size() + offsets.size());
 
-	for (size_t y = 0; y < rows; ++y)
+	for (AreaOffsetVector::const_iterator it = offsets.begin(); it != offsets.end(); ++it)
 	{
-		for (size_t x = 0; x < cols; ++x)
+		int32_t tmpPosX = targetPos.x + it->x;
+		int32_t tmpPosY = targetPos.y + it->y;
+		int32_t tmpPosZ = targetPos.z;
+
+		if (tmpPosX >= 0 && tmpPosX < 0xFFFF &&
+		        tmpPosY >= 0 && tmpPosY < 0xFFFF &&
+		        tmpPosZ >= 0 && tmpPosZ < MAP_MAX_LAYERS)
 		{
-			if (area->getValue(y, x) != 0)
+			if (g_game.isSightClear(targetPos, Position(tmpPosX, tmpPosY, tmpPosZ), true))
 			{
-				if (tmpPosX >= 0 && tmpPosX < 0xFFFF &&
-				        tmpPosY >= 0 && tmpPosY < 0xFFFF &&
-				        tmpPosZ >= 0 && tmpPosZ < MAP_MAX_LAYERS)
-				{
-					if (g_game.isSightClear(targetPos, Position(tmpPosX, tmpPosY, tmpPosZ), true))
-					{
-						tile = g_game.getTile(tmpPosX, tmpPosY, tmpPosZ);
-
-						if (!tile)
-						{
-							// This tile will never have anything on it
-							tile = new StaticTile(tmpPosX, tmpPosY, tmpPosZ);
-							g_game.setTile(tile);
-						}
+				Tile* tile = g_game.getTile(tmpPosX, tmpPosY, tmpPosZ);
 
-						list.push_back(tile);
-					}
+				if (!tile)
+				{
+					// This tile will never have anything on it
+					tile = new StaticTile(tmpPosX, tmpPosY, tmpPosZ);
+					g_game.setTile(tile);
 				}
-			}
 
-			tmpPosX += 1;
+				list.push_back(tile);
+			}
 		}
-
-		tmpPosX -= cols;
-		tmpPosY += 1;
 	}
 
 	return true;
@@ -1816,14 +1851,7 @@ MatrixArea* AreaCombat::getArea(const Position& centerPos, const Position& targe
 		}
 	}
 
-	AreaCombatMap::const_iterator it = areas.find(dir);
-
-	if (it != areas.end())
-	{
-		return it->second;
-	}
-
-	return NULL;
+	return areas[dir];
 }
 
 int32_t AreaCombat::round(const float& v) const
@@ -1873,20 +1901,20 @@ void AreaCombat::setupArea(const std::list<uint32_t>& list, const uint32_t& rows
 {
 	MatrixArea* area = createArea(list, rows);
 	//NORTH
-	areas[NORTH] = area;
+	setArea(NORTH, area);
 	uint32_t maxOutput = std::max(area->getCols(), area->getRows()) * 2;
 	//SOUTH
 	MatrixArea* southArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(area, southArea, MATRIXOPERATION_ROTATE180);
-	areas[SOUTH] = southArea;
+	setArea(SOUTH, southArea);
 	//EAST
 	MatrixArea* eastArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(area, eastArea, MATRIXOPERATION_ROTATE90);
-	areas[EAST] = eastArea;
+	setArea(EAST, eastArea);
 	//WEST
 	MatrixArea* westArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(area, westArea, MATRIXOPERATION_ROTATE270);
-	areas[WEST] = westArea;
+	setArea(WEST, westArea);
 }
 
 void AreaCombat::setupArea(const int32_t& length, const int32_t& spread)
@@ -1984,20 +2012,20 @@ void AreaCombat::setupExtArea(const std::list<uint32_t>& list, const uint32_t& r
 	hasExtArea = true;
 	MatrixArea* area = createArea(list, rows);
 	//NORTH-WEST
-	areas[NORTHWEST] = area;
+	setArea(NORTHWEST, area);
 	uint32_t maxOutput = std::max(area->getCols(), area->getRows()) * 2;
 	//NORTH-EAST
 	MatrixArea* neArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(area, neArea, MATRIXOPERATION_MIRROR);
-	areas[NORTHEAST] = neArea;
+	setArea(NORTHEAST, neArea);
 	//SOUTH-WEST
 	MatrixArea* swArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(area, swArea, MATRIXOPERATION_FLIP);
-	areas[SOUTHWEST] = swArea;
+	setArea(SOUTHWEST, swArea);
 	//SOUTH-EAST
 	MatrixArea* seArea = new MatrixArea(maxOutput, maxOutput);
 	copyArea(swArea, seArea, MATRIXOPERATION_MIRROR);
-	areas[SOUTHEAST] = seArea;
+	setArea(SOUTHEAST, seArea);
 }
 
 //**********************************************************
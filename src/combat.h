@@ -116,6 +116,15 @@ struct Combat2Var
 	int32_t maxChange;
 };
 
+struct AreaOffset
+{
+	int16_t x;
+	int16_t y;
+};
+
+typedef std::vector<AreaOffset> AreaOffsetVector;
+typedef std::vector<Tile*> CombatTileList;
+
 class MatrixArea
 {
 public:
@@ -135,6 +144,10 @@ public:
 	const bool* operator[](const uint32_t& i) const;
 	bool* operator[](const uint32_t& i);
 
+	// the set cells as offsets from the center, rebuilt once the matrix is filled
+	void updateOffsets();
+	const AreaOffsetVector& getOffsets() const;
+
 protected:
 	uint32_t centerX;
 	uint32_t centerY;
@@ -142,9 +155,11 @@ protected:
     size_t rows;
     size_t cols;
 	bool** data_;
+	AreaOffsetVector offsets;
 };
 
-typedef std::map<Direction, MatrixArea* > AreaCombatMap;
+// indexed by Direction
+#define AREACOMBAT_DIRECTIONS 8
 
 class AreaCombat
 {
@@ -155,7 +170,7 @@ public:
 	AreaCombat(const AreaCombat& rhs);
 
 	ReturnValue doCombat(Creature* attacker, const Position& pos, const Combat& combat) const;
-	bool getList(const Position& centerPos, const Position& targetPos, std::list<Tile*>& list) const;
+	bool getList(const Position& centerPos, const Position& targetPos, CombatTileList& list) const;
 
 	void setupArea(const std::list<uint32_t>& list, const uint32_t& rows);
 	void setupArea(const int32_t& length, const int32_t& spread);
@@ -178,9 +193,10 @@ protected:
 	void copyArea(const MatrixArea* input, MatrixArea* output, const MatrixOperation_t& op) const;
 
 	MatrixArea* getArea(const Position& centerPos, const Position& targetPos) const;
+	void setArea(const Direction& dir, MatrixArea* area);
 	int32_t round(const float& v) const;
 
-	AreaCombatMap areas;
+	MatrixArea* areas[AREACOMBAT_DIRECTIONS];
 	bool hasExtArea;
 };
 
@@ -211,7 +227,7 @@ public:
 	                           const AreaCombat* area, const CombatParams& params);
 
 	static void getCombatArea(const Position& centerPos, const Position& targetPos,
-	                          const AreaCombat* area, std::list<Tile*>& list);
+	                          const AreaCombat* area, CombatTileList& list);
 
 	static bool isInPvpZone(const Creature* attacker, const Creature* target);
 	static bool isUnjustKill(const Creature* attacker, const Creature* target);
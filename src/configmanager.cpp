@@ -236,6 +236,8 @@ bool ConfigManager::loadFile(const std::string& _filename)
 	m_confInteger[MAX_AMOUNT_ITEMS_INSIDE_CONTAINERS] = getGlobalNumber(L, "max_amount_items_inside_containers", 5000);
 	m_confInteger[MAX_DEEPNESS_OF_CHAIN_OF_CONTAINERS] = getGlobalNumber(L, "max_deepness_of_chain_of_containers", 500);
 	m_confInteger[BIND_ONLY_GLOBAL_ADDRESS]	= getGlobalBoolean(L, "bind_only_global_address", false);
+	m_confInteger[SAVE_PLAYERS_PER_TICK] = getGlobalNumber(L, "save_players_per_tick", 25);
+	m_confInteger[SAVE_TICK_INTERVAL] = getGlobalNumber(L, "save_tick_interval", 50);
 	m_isLoaded = true;
 	return true;
 }
@@ -176,6 +176,8 @@ public:
 		MAX_AMOUNT_ITEMS_INSIDE_CONTAINERS,
 		MAX_DEEPNESS_OF_CHAIN_OF_CONTAINERS,
 		BIND_ONLY_GLOBAL_ADDRESS,
+		SAVE_PLAYERS_PER_TICK,
+		SAVE_TICK_INTERVAL,
 		LAST_INTEGER_CONFIG /* this must be the last one */
 	};
 
@@ -177,6 +177,8 @@ void Connection::closeSocket()
 #endif
 		m_pendingRead = 0;
 		m_pendingWrite = 0;
+		// never written, the running write releases its own messages
+		m_outputQueue.clear();
 
 		try
 		{
@@ -439,7 +441,7 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	m_connectionLock.unlock();
 }
 
-bool Connection::send(OutputMessage_ptr msg)
+bool Connection::send(OutputMessage_ptr msg, bool flush /*= true*/)
 {
 #ifdef __DEBUG_NET_DETAIL__
 	std::cout << "Connection::send init" << std::endl;
@@ -452,32 +454,44 @@ bool Connection::send(OutputMessage_ptr msg)
 		return false;
 	}
 
-	if (m_pendingWrite == 0)
-	{
-		msg->getProtocol()->onSendMessage(msg);
-		TRACK_MESSAGE(msg);
+	msg->getProtocol()->onSendMessage(msg);
+	TRACK_MESSAGE(msg);
 #ifdef __DEBUG_NET_DETAIL__
-		std::cout << "Connection::send " << msg->getMessageLength() << std::endl;
+	std::cout << "Connection::send " << msg->getMessageLength() << std::endl;
 #endif
-		internalSend(msg);
-	}
-	else
+	m_outputQueue.push_back(msg);
+
+	if (flush && m_pendingWrite == 0)
 	{
-#ifdef __DEBUG_NET__
-		std::cout << "Connection::send Adding to queue " << msg->getMessageLength() << std::endl;
-#endif
-		TRACK_MESSAGE(msg);
-		OutputMessagePool* outputPool = OutputMessagePool::getInstance();
-		outputPool->addToAutoSend(msg);
+		internalSend();
 	}
 
 	m_connectionLock.unlock();
 	return true;
 }
 
-void Connection::internalSend(OutputMessage_ptr msg)
+void Connection::flushOutput()
 {
-	TRACK_MESSAGE(msg);
+	boost::recursive_mutex::scoped_lock lockClass(m_connectionLock);
+
+	if (m_connectionState == CONNECTION_STATE_OPEN && !m_writeError &&
+	        m_pendingWrite == 0 && !m_outputQueue.empty())
+	{
+		internalSend();
+	}
+}
+
+void Connection::internalSend()
+{
+	// all queued messages go out in a single gathered write
+	m_writeQueue.swap(m_outputQueue);
+	m_writeBuffers.clear();
+
+	for (std::vector<OutputMessage_ptr>::iterator it = m_writeQueue.begin(); it != m_writeQueue.end(); ++it)
+	{
+		TRACK_MESSAGE(*it);
+		m_writeBuffers.push_back(boost::asio::buffer((*it)->getOutputBuffer(), (*it)->getMessageLength()));
+	}
 
 	try
 	{
@@ -485,9 +499,8 @@ void Connection::internalSend(OutputMessage_ptr msg)
 		m_writeTimer.expires_from_now(boost::posix_time::seconds(Connection::write_timeout));
 		m_writeTimer.async_wait(boost::bind(&Connection::handleWriteTimeout, boost::weak_ptr<Connection>(shared_from_this()),
 		                                    boost::asio::placeholders::error));
-		boost::asio::async_write(getHandle(),
-		                         boost::asio::buffer(msg->getOutputBuffer(), msg->getMessageLength()),
-		                         boost::bind(&Connection::onWriteOperation, shared_from_this(), msg, boost::asio::placeholders::error));
+		boost::asio::async_write(getHandle(), m_writeBuffers,
+		                         boost::bind(&Connection::onWriteOperation, shared_from_this(), boost::asio::placeholders::error));
 	}
 	catch (boost::system::system_error& e)
 	{
@@ -516,15 +529,14 @@ uint32_t Connection::getIP() const
 	}
 }
 
-void Connection::onWriteOperation(OutputMessage_ptr msg, const boost::system::error_code& error)
+void Connection::onWriteOperation(const boost::system::error_code& error)
 {
 #ifdef __DEBUG_NET_DETAIL__
 	std::cout << "onWriteOperation" << std::endl;
 #endif
 	m_connectionLock.lock();
 	m_writeTimer.cancel();
-	TRACK_MESSAGE(msg);
-	msg.reset();
+	m_writeQueue.clear();
 
 	if (error)
 	{
@@ -540,6 +552,13 @@ void Connection::onWriteOperation(OutputMessage_ptr msg, const boost::system::er
 	}
 
 	--m_pendingWrite;
+
+	// whatever was queued meanwhile goes out now
+	if (!m_outputQueue.empty())
+	{
+		internalSend();
+	}
+
 	m_connectionLock.unlock();
 }
 
@@ -27,6 +27,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <vector>
 #include "networkmessage.h"
 
 class Protocol;
@@ -123,7 +124,10 @@ public:
 	void acceptConnection(Protocol* protocol);
 	void acceptConnection();
 
-	bool send(OutputMessage_ptr msg);
+	// the message is queued and, with flush, written right away unless a
+	// write is in progress, then it goes out together with the next batch
+	bool send(OutputMessage_ptr msg, bool flush = true);
+	void flushOutput();
 
 	uint32_t getIP() const;
 
@@ -140,7 +144,7 @@ private:
 	void parseHeader(const boost::system::error_code& error);
 	void parsePacket(const boost::system::error_code& error);
 
-	void onWriteOperation(OutputMessage_ptr msg, const boost::system::error_code& error);
+	void onWriteOperation(const boost::system::error_code& error);
 
 	void onStopOperation();
 	void handleReadError(const boost::system::error_code& error);
@@ -156,7 +160,7 @@ private:
 	void onReadTimeout();
 	void onWriteTimeout();
 
-	void internalSend(OutputMessage_ptr msg);
+	void internalSend();
 
 	NetworkMessage m_msg;
 	boost::asio::ip::tcp::socket* m_socket;
@@ -176,6 +180,12 @@ private:
 	boost::recursive_mutex m_connectionLock;
 
 	Protocol* m_protocol;
+
+	// messages waiting for the running write
+	std::vector<OutputMessage_ptr> m_outputQueue;
+	// messages of the running write, they own its buffers until it finishes
+	std::vector<OutputMessage_ptr> m_writeQueue;
+	std::vector<boost::asio::const_buffer> m_writeBuffers;
 };
 
 #endif
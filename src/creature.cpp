@@ -40,8 +40,8 @@
 #endif
 
 boost::recursive_mutex AutoID::autoIDLock;
-uint32_t AutoID::count = 1000;
-AutoID::list_type AutoID::list;
+std::vector<uint32_t> AutoID::generations;
+std::deque<uint32_t> AutoID::freeSlots;
 
 extern Game g_game;
 extern ConfigManager g_config;
@@ -2319,9 +2319,9 @@ int32_t Creature::getStepDuration() const
 	int32_t duration = 0;
 	const Tile* tile = getTile();
 
-	if (tile && tile->ground)
+	if (tile && tile->hasGround())
 	{
-		uint32_t groundId = tile->ground->getID();
+		uint32_t groundId = tile->getGroundId();
 		uint16_t groundSpeed = Item::items[groundId].speed;
 		uint32_t stepSpeed = getStepSpeed();
 
@@ -143,6 +143,11 @@ public:
 	bool isInRange(const Position& startPos, const Position& testPos,
 	               const FindPathParams& fpp) const;
 
+	const Position& getTargetPos() const
+	{
+		return targetPos;
+	}
+
 protected:
 	Position targetPos;
 };
@@ -117,11 +117,28 @@ DBQuery::~DBQuery()
 DBInsert::DBInsert(Database* db)
 {
 	m_db = db;
+	m_queryList = NULL;
 	m_rows = 0;
 	// checks if current database engine supports multiline INSERTs
 	m_multiLine = m_db->getParam(DBPARAM_MULTIINSERT) != 0;
 }
 
+void DBInsert::setQueryList(std::vector<std::string>* queryList)
+{
+	m_queryList = queryList;
+}
+
+bool DBInsert::runQuery(const std::string& query)
+{
+	if (m_queryList)
+	{
+		m_queryList->push_back(query);
+		return true;
+	}
+
+	return m_db->executeQuery(query);
+}
+
 void DBInsert::setQuery(const std::string& query)
 {
 	m_query = query;
@@ -160,7 +177,7 @@ bool DBInsert::addRow(const std::string& row)
 	else
 	{
 		// executes INSERT for current row
-		return m_db->executeQuery(m_query + "(" + row + ")");
+		return runQuery(m_query + "(" + row + ")");
 	}
 }
 
@@ -183,7 +200,7 @@ bool DBInsert::execute()
 
 		m_rows = 0;
 		// executes buffer
-		bool res = m_db->executeQuery(m_query + m_buf);
+		bool res = runQuery(m_query + m_buf);
 		m_buf = "";
 		return res;
 	}
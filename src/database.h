@@ -24,6 +24,7 @@
 #include "definitions.h"
 #include <boost/thread.hpp>
 #include <sstream>
+#include <vector>
 
 #ifdef MULTI_SQL_DRIVERS
 #define DATABASE_VIRTUAL virtual
@@ -301,6 +302,13 @@ public:
 	DBInsert(Database* db);
 	~DBInsert() {};
 
+	/**
+	* Collects the generated INSERT queries into given list instead of executing them.
+	*
+	* @param std::vector<std::string>* list to store queries in, NULL to execute again
+	*/
+	void setQueryList(std::vector<std::string>* queryList);
+
 	/**
 	* Sets query prototype.
 	*
@@ -332,7 +340,10 @@ public:
 	uint64_t getInsertID();
 
 protected:
+	bool runQuery(const std::string& query);
+
 	Database* m_db;
+	std::vector<std::string>* m_queryList;
 	bool m_multiLine;
 	uint32_t m_rows;
 	std::string m_query;
@@ -29,6 +29,7 @@ Depot::Depot(const uint16_t& _type)
 	depotId = 0;
 	maxSize = 30;
 	maxDepotLimit = 1500;
+	saveDirty = true;
 }
 
 Depot::~Depot()
@@ -131,6 +132,8 @@ ReturnValue Depot::__queryMaxCount(int32_t index, const Thing* thing, uint32_t c
 
 void Depot::postAddNotification(Thing* thing, const Cylinder* oldParent, int32_t index, cylinderlink_t link /*= LINK_OWNER*/, bool isNewItem /*=true*/)
 {
+	saveDirty = true;
+
 	if (getParent())
 	{
 		getParent()->postAddNotification(thing, oldParent, index, LINK_PARENT, isNewItem);
@@ -139,6 +142,8 @@ void Depot::postAddNotification(Thing* thing, const Cylinder* oldParent, int32_t
 
 void Depot::postRemoveNotification(Thing* thing, const Cylinder* newParent, int32_t index, bool isCompleteRemoval, cylinderlink_t link /*= LINK_OWNER*/)
 {
+	saveDirty = true;
+
 	if (getParent())
 	{
 		getParent()->postRemoveNotification(thing, newParent, index, isCompleteRemoval, LINK_PARENT);
@@ -36,6 +36,15 @@ public:
 	virtual Attr_ReadValue readAttr(AttrTypes_t attr, PropStream& propStream);
 
 	const uint32_t& getDepotId() const;
+
+	void setSaveDirty(bool dirty)
+	{
+		saveDirty = dirty;
+	}
+	bool isSaveDirty() const
+	{
+		return saveDirty;
+	}
 	void setMaxDepotLimit(const uint32_t& maxitems);
 	void setDepotId(const uint32_t& id);
 
@@ -55,6 +64,7 @@ public:
 private:
 	uint32_t maxDepotLimit;
 	uint32_t depotId;
+	bool saveDirty;
 };
 
 #endif // __OTSERV_DEPOT_H__
@@ -72,6 +72,8 @@ Game::Game()
 	checkLightEvent = 0;
 	checkCreatureEvent = 0;
 	checkDecayEvent = 0;
+	checkPlayerSaveEvent = 0;
+	playerSaveStart = 0;
 	last_bucket = 0;
 	int daycycle = 3600;
 	//(1440 minutes/day)/(3600 seconds/day)*10 seconds event interval
@@ -82,6 +84,13 @@ Game::Game()
 	light_hour = SUNRISE + (SUNSET - SUNRISE) / 2;
 	lightlevel = LIGHT_LEVEL_DAY;
 	light_state = LIGHT_STATE_DAY;
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+
+	for (uint32_t i = 0; i < EVENT_CREATURECOUNT; ++i)
+	{
+		checkCreatureTimes[i] = 0;
+	}
+#endif
 }
 
 Game::~Game()
@@ -195,12 +204,18 @@ bool Game::saveServer(bool payHouses, bool shallowSave /*=false*/)
 	uint64_t start = OTSYS_TIME();
 	saveGameState();
 
+	//players are snapshotted a few per tick and written by the save thread
 	for (AutoList<Player>::listiterator it = Player::listPlayer.list.begin();
 	        it != Player::listPlayer.list.end();
 	        ++it)
 	{
-		it->second->loginPosition = it->second->getPosition();
-		IOPlayer::instance()->savePlayer(it->second, shallowSave);
+		playerSaveQueue.push_back(std::make_pair(it->first, shallowSave));
+	}
+
+	if (checkPlayerSaveEvent == 0 && !playerSaveQueue.empty())
+	{
+		playerSaveStart = OTSYS_TIME();
+		checkPlayerSaves();
 	}
 
 	if (shallowSave)
@@ -219,6 +234,42 @@ bool Game::saveServer(bool payHouses, bool shallowSave /*=false*/)
 	return ret;
 }
 
+void Game::checkPlayerSaves()
+{
+	checkPlayerSaveEvent = 0;
+	int32_t count = g_config.getNumber(ConfigManager::SAVE_PLAYERS_PER_TICK);
+
+	while (count > 0 && !playerSaveQueue.empty())
+	{
+		std::pair<uint32_t, bool> entry = playerSaveQueue.front();
+		playerSaveQueue.pop_front();
+		Player* player = getPlayerByID(entry.first);
+
+		//players that logged out in the meantime were saved on logout
+		if (!player)
+		{
+			continue;
+		}
+
+		player->loginPosition = player->getPosition();
+		IOPlayer::instance()->queuePlayerSave(player, entry.second);
+		--count;
+	}
+
+	if (!playerSaveQueue.empty())
+	{
+		checkPlayerSaveEvent =
+		    g_scheduler.addEvent(createSchedulerTask(g_config.getNumber(ConfigManager::SAVE_TICK_INTERVAL),
+		                         boost::bind(&Game::checkPlayerSaves, this)));
+		return;
+	}
+
+	IOPlayer::PlayerSaveStats stats = IOPlayer::instance()->getSaveStats();
+	std::cout << "Notice: Players snapshotted in " << (OTSYS_TIME() - playerSaveStart) / (1000.) <<
+	          "s, " << stats.pending << " waiting to be written." << std::endl;
+	IOPlayer::instance()->finishSaveBatch();
+}
+
 void Game::loadGameState()
 {
 	ScriptEnviroment::loadGameState();
@@ -421,7 +472,7 @@ Thing* Game::internalGetThing(Player* player, const Position& pos,
 				if (!thing)
 				{
 					//and finally the ground
-					thing = tile->ground;
+					thing = tile->getGround();
 				}
 			}
 			else
@@ -596,17 +647,15 @@ Player* Game::getPlayerByID(const uint32_t& id)
 
 Creature* Game::getCreatureByName(const std::string& s)
 {
-	std::string txt1 = asUpperCaseString(s);
+	CreatureNameMap::iterator it = creatureNameIndex.find(asUpperCaseString(s));
 
-	for (AutoList<Creature>::listiterator it = listCreature.list.begin(); it != listCreature.list.end(); ++it)
+	if (it != creatureNameIndex.end())
 	{
-		if (!(*it).second->isRemoved())
+		for (std::vector<Creature*>::iterator cit = it->second.begin(); cit != it->second.end(); ++cit)
 		{
-			std::string txt2 = asUpperCaseString((*it).second->getName());
-
-			if (txt1 == txt2)
+			if (!(*cit)->isRemoved())
 			{
-				return it->second;
+				return *cit;
 			}
 		}
 	}
@@ -616,18 +665,13 @@ Creature* Game::getCreatureByName(const std::string& s)
 
 Player* Game::getPlayerByName(const std::string& s)
 {
-	std::string txt1 = asUpperCaseString(s);
+	PlayerNameMap::iterator it = playerNameIndex.find(asUpperCaseString(s));
 
-	for (AutoList<Player>::listiterator it = Player::listPlayer.list.begin(); it != Player::listPlayer.list.end(); ++it)
+	if (it != playerNameIndex.end())
 	{
-		if (!(*it).second->isRemoved())
+		if (!it->second->isRemoved())
 		{
-			std::string txt2 = asUpperCaseString((*it).second->getName());
-
-			if (txt1 == txt2)
-			{
-				return it->second;
-			}
+			return it->second;
 		}
 	}
 
@@ -733,22 +777,23 @@ ReturnValue Game::getPlayerByNameWildcard(const std::string& s, Player* &player)
 	Player* lastFound = NULL;
 	std::string txt1 = asUpperCaseString(s.substr(0, s.length() - 1));
 
-	for (AutoList<Player>::listiterator it = Player::listPlayer.list.begin(); it != Player::listPlayer.list.end(); ++it)
+	//the prefix index is sorted, so every match is in a single run starting at lower_bound
+	for (PlayerPrefixMap::iterator it = playerPrefixIndex.lower_bound(txt1); it != playerPrefixIndex.end(); ++it)
 	{
-		if (!(*it).second->isRemoved())
+		if (it->first.compare(0, txt1.length(), txt1) != 0)
 		{
-			std::string txt2 = asUpperCaseString((*it).second->getName());
+			break;
+		}
 
-			if (txt2.substr(0, txt1.length()) == txt1)
+		if (!it->second->isRemoved())
+		{
+			if (!lastFound)
 			{
-				if (!lastFound)
-				{
-					lastFound = (*it).second;
-				}
-				else
-				{
-					return RET_NAMEISTOOAMBIGIOUS;
-				}
+				lastFound = it->second;
+			}
+			else
+			{
+				return RET_NAMEISTOOAMBIGIOUS;
 			}
 		}
 	}
@@ -831,6 +876,7 @@ bool Game::internalPlaceCreature(Creature* creature, const Position& pos, bool e
 	creature->setID();
 	listCreature.addList(creature);
 	creature->addList();
+	addCreatureName(creature);
 	return true;
 }
 
@@ -863,7 +909,15 @@ bool Game::placeCreature(Creature* creature, const Position& pos, bool extendedP
 
 	int32_t newIndex = creature->getParent()->__getIndexOfThing(creature);
 	creature->getParent()->postAddNotification(creature, NULL, newIndex);
-	addCreatureCheck(creature);
+
+	// monsters join the creature checks themselves once they stop being idle
+	Monster* monster = creature->getMonster();
+
+	if (!monster || !monster->getIdleStatus())
+	{
+		addCreatureCheck(creature);
+	}
+
 	creature->onPlacedCreature();
 	return true;
 }
@@ -937,6 +991,7 @@ bool Game::removeCreature(Creature* creature, bool isLogout /*= true*/)
 	int32_t oldIndex = tile->__getIndexOfThing(creature);
 	creature->getParent()->postRemoveNotification(creature, NULL, oldIndex, true);
 	listCreature.removeList(creature->getID());
+	removeCreatureName(creature);
 	creature->onRemoved();
 	FreeThing(creature);
 	removeCreatureCheck(creature);
@@ -951,6 +1006,58 @@ bool Game::removeCreature(Creature* creature, bool isLogout /*= true*/)
 	return true;
 }
 
+void Game::addCreatureName(Creature* creature)
+{
+	std::string name = asUpperCaseString(creature->getName());
+	creatureNameIndex[name].push_back(creature);
+
+	if (Player* player = creature->getPlayer())
+	{
+		playerNameIndex[name] = player;
+		playerPrefixIndex[name] = player;
+	}
+}
+
+void Game::removeCreatureName(Creature* creature)
+{
+	std::string name = asUpperCaseString(creature->getName());
+	CreatureNameMap::iterator it = creatureNameIndex.find(name);
+
+	if (it != creatureNameIndex.end())
+	{
+		std::vector<Creature*>& creatures = it->second;
+		std::vector<Creature*>::iterator cit = std::find(creatures.begin(), creatures.end(), creature);
+
+		if (cit != creatures.end())
+		{
+			*cit = creatures.back();
+			creatures.pop_back();
+		}
+
+		if (creatures.empty())
+		{
+			creatureNameIndex.erase(it);
+		}
+	}
+
+	if (creature->getPlayer())
+	{
+		PlayerNameMap::iterator pit = playerNameIndex.find(name);
+
+		if (pit != playerNameIndex.end() && pit->second == creature)
+		{
+			playerNameIndex.erase(pit);
+		}
+
+		PlayerPrefixMap::iterator xit = playerPrefixIndex.find(name);
+
+		if (xit != playerPrefixIndex.end() && xit->second == creature)
+		{
+			playerPrefixIndex.erase(xit);
+		}
+	}
+}
+
 bool Game::playerMoveThing(const uint32_t& playerId, const Position& fromPos,
 	const uint16_t& spriteId, const uint8_t& fromStackPos, const Position& toPos, const uint8_t& count)
 {
@@ -1173,11 +1280,11 @@ ReturnValue Game::internalMoveCreature(Creature* creature,
 		{
 			Tile* tmpTile = getTile(currentPos.x, currentPos.y, currentPos.z - 1);
 
-			if (!tmpTile || (!tmpTile->ground && !tmpTile->hasProperty(BLOCKSOLID)))
+			if (!tmpTile || (!tmpTile->hasGround() && !tmpTile->hasProperty(BLOCKSOLID)))
 			{
 				tmpTile = getTile(destPos.x, destPos.y, destPos.z - 1);
 
-				if (tmpTile && tmpTile->ground && !tmpTile->hasProperty(BLOCKSOLID))
+				if (tmpTile && tmpTile->hasGround() && !tmpTile->hasProperty(BLOCKSOLID))
 				{
 					newFlags = flags | FLAG_IGNOREBLOCKITEM | FLAG_IGNOREBLOCKCREATURE;
 					destPos.z -= 1;
@@ -1189,7 +1296,7 @@ ReturnValue Game::internalMoveCreature(Creature* creature,
 			//try go down
 			Tile* tmpTile = getTile(destPos);
 
-			if (currentPos.z != 7 && (!tmpTile || (!tmpTile->ground && !tmpTile->hasProperty(BLOCKSOLID))))
+			if (currentPos.z != 7 && (!tmpTile || (!tmpTile->hasGround() && !tmpTile->hasProperty(BLOCKSOLID))))
 			{
 				tmpTile = getTile(destPos.x, destPos.y, destPos.z + 1);
 
@@ -3245,6 +3352,8 @@ bool Game::playerWriteItem(const uint32_t& playerId, const uint32_t& windowTextI
 		writeItem->resetWrittenDate();
 	}
 
+	Player::setItemSaveDirty(writeItem);
+
 	uint16_t newId = Item::items[writeItem->getID()].writeOnceItemId;
 
 	if (newId != 0)
@@ -4658,11 +4767,15 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 	//send to client
 	Player* tmpPlayer = NULL;
 
-	for (it = list.begin(); it != list.end(); ++it)
 	{
-		if ((tmpPlayer = (*it)->getPlayer()))
+		ProtocolGame::Broadcast broadcast;
+
+		for (it = list.begin(); it != list.end(); ++it)
 		{
-			tmpPlayer->sendCreatureSay(creature, type, text);
+			if ((tmpPlayer = (*it)->getPlayer()))
+			{
+				tmpPlayer->sendCreatureSay(creature, type, text);
+			}
 		}
 	}
 
@@ -4782,6 +4895,18 @@ uint32_t Game::getCreaturesOnline() const
 	return (uint32_t)listCreature.list.size();
 }
 
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+size_t Game::getCheckCreatureCount(const uint32_t& bucket) const
+{
+	return checkCreatureVectors[bucket].size();
+}
+
+const int64_t& Game::getCheckCreatureTime(const uint32_t& bucket) const
+{
+	return checkCreatureTimes[bucket];
+}
+#endif
+
 void Game::checkCreatures()
 {
 	g_scheduler.addEvent(createSchedulerTask(
@@ -4805,10 +4930,14 @@ void Game::checkCreatures()
 	}
 
 	std::vector<Creature*>& checkCreatureVector = checkCreatureVectors[checkCreatureLastIndex];
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	boost::system_time startTime = boost::get_system_time();
+#endif
+	size_t index = 0;
 
-	for (it = checkCreatureVector.begin(); it != checkCreatureVector.end();)
+	while (index < checkCreatureVector.size())
 	{
-		creature = (*it);
+		creature = checkCreatureVector[index];
 
 		if (creature->creatureCheck)
 		{
@@ -4821,16 +4950,21 @@ void Game::checkCreatures()
 				creature->onDie();
 			}
 
-			++it;
+			++index;
 		}
 		else
 		{
+			// the last creature takes its place, the order does not matter
 			creature->checkCreatureVectorIndex = -1;
-			it = checkCreatureVector.erase(it);
+			checkCreatureVector[index] = checkCreatureVector.back();
+			checkCreatureVector.pop_back();
 			FreeThing(creature);
 		}
 	}
 
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	checkCreatureTimes[checkCreatureLastIndex] = (boost::get_system_time() - startTime).total_microseconds();
+#endif
 	cleanup();
 }
 
@@ -4839,7 +4973,7 @@ void Game::changeSpeed(Creature* creature, const int32_t& varSpeedDelta)
 	int32_t varSpeed = creature->getSpeed() - creature->getBaseSpeed();
 	varSpeed += varSpeedDelta;
 	creature->setSpeed(varSpeed);
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 	SpectatorVec::const_iterator it;
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -4905,7 +5039,7 @@ void Game::internalCreatureChangeVisible(Creature* creature, bool visible)
 #ifdef __MIN_PVP_LEVEL_APPLIES_TO_SUMMONS__
 void Game::forceClientsToReloadCreature(const Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 	SpectatorVec::const_iterator it;
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -4923,7 +5057,7 @@ void Game::forceClientsToReloadCreature(const Creature* creature)
 
 void Game::changeLight(const Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 	//send to client
 	Player* tmpPlayer = NULL;
 
@@ -4951,7 +5085,7 @@ bool Game::combatBlockHit(const CombatType_t& combatType, Creature* attacker,
 
 	const Position& targetPos = target->getPosition();
 
-	const SpectatorVec& list = getSpectators(targetPos);
+	const SpectatorVec& list = getPlayerSpectators(targetPos);
 
 	if (!target->isAttackable() || Combat::canDoCombat(attacker, target) != RET_NOERROR)
 	{
@@ -5020,7 +5154,7 @@ bool Game::combatChangeHealth(CombatType_t combatType, Creature* attacker, Creat
 bool Game::combatChangeHealth(CombatType_t combatType, MagicEffectClasses customHitEffect, TextColor_t customTextColor, Creature* attacker, Creature* target, int32_t healthChange)
 {
 	const Position& targetPos = target->getPosition();
-	const SpectatorVec& list = getSpectators(targetPos);
+	const SpectatorVec& list = getPlayerSpectators(targetPos);
 
 	if (healthChange > 0)
 	{
@@ -5195,7 +5329,7 @@ bool Game::combatChangeHealth(CombatType_t combatType, MagicEffectClasses custom
 bool Game::combatChangeMana(Creature* attacker, Creature* target, int32_t manaChange)
 {
 	const Position& targetPos = target->getPosition();
-	const SpectatorVec& list = getSpectators(targetPos);
+	const SpectatorVec& list = getPlayerSpectators(targetPos);
 
 	if (manaChange > 0)
 	{
@@ -5232,13 +5366,14 @@ bool Game::combatChangeMana(Creature* attacker, Creature* target, int32_t manaCh
 
 void Game::addCreatureHealth(const Creature* target)
 {
-	const SpectatorVec& list = getSpectators(target->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(target->getPosition());
 	addCreatureHealth(list, target);
 }
 
 void Game::addCreatureHealth(const SpectatorVec& list, const Creature* target)
 {
 	Player* player = NULL;
+	ProtocolGame::Broadcast broadcast;
 
 	for (SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
@@ -5251,7 +5386,7 @@ void Game::addCreatureHealth(const SpectatorVec& list, const Creature* target)
 
 void Game::addAnimatedText(const Position& pos, const uint8_t& textColor, const std::string& text)
 {
-	const SpectatorVec& list = getSpectators(pos);
+	const SpectatorVec& list = getPlayerSpectators(pos);
 	addAnimatedText(list, pos, textColor, text);
 }
 
@@ -5259,6 +5394,7 @@ void Game::addAnimatedText(const SpectatorVec& list, const Position& pos,
 	const uint8_t& textColor, const std::string& text)
 {
 	Player* player = NULL;
+	ProtocolGame::Broadcast broadcast;
 
 	for (SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
@@ -5271,13 +5407,14 @@ void Game::addAnimatedText(const SpectatorVec& list, const Position& pos,
 
 void Game::addMagicEffect(const Position& pos, const uint8_t& effect)
 {
-	const SpectatorVec& list = getSpectators(pos);
+	const SpectatorVec& list = getPlayerSpectators(pos);
 	addMagicEffect(list, pos, effect);
 }
 
 void Game::addMagicEffect(const SpectatorVec& list, const Position& pos, const uint8_t& effect)
 {
 	Player* player = NULL;
+	ProtocolGame::Broadcast broadcast;
 
 	for (SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
@@ -5291,10 +5428,11 @@ void Game::addMagicEffect(const SpectatorVec& list, const Position& pos, const u
 void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, const uint8_t& effect)
 {
 	SpectatorVec list;
-	getSpectators(list, fromPos, false);
-	getSpectators(list, toPos, true);
+	getPlayerSpectators(list, fromPos, false);
+	getPlayerSpectators(list, toPos, true);
 	//send to client
 	Player* tmpPlayer = NULL;
+	ProtocolGame::Broadcast broadcast;
 
 	for (SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
@@ -5307,7 +5445,7 @@ void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, con
 
 void Game::updateCreatureSkull(Player* player)
 {
-	const SpectatorVec& list = getSpectators(player->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(player->getPosition());
 	//send to client
 	Player* tmpPlayer = NULL;
 
@@ -5323,7 +5461,7 @@ void Game::updateCreatureSkull(Player* player)
 #ifdef __GUILDWARSLUARELOAD__
 void Game::updateCreatureEmblem(Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 	//send to client
 	Player* tmpPlayer = NULL;
 
@@ -5430,6 +5568,7 @@ void Game::checkDecay()
 		}
 
 		item->decreaseDuration(decreaseTime);
+		Player::setItemSaveDirty(item);
 #ifdef __DEBUG__
 		std::cout << "checkDecay: " << item << ", id:" << item->getID() << ", name: " << item->getName() << ", duration: " << item->getDuration() << std::endl;
 #endif
@@ -5549,6 +5688,19 @@ const SpectatorVec& Game::getSpectators(const Position& centerPos)
 	return map->getSpectators(centerPos);
 }
 
+void Game::getPlayerSpectators(SpectatorVec& list, const Position& centerPos,
+                               bool checkforduplicate /*= false*/, bool multifloor /*= false*/,
+                               const int32_t& minRangeX /*= 0*/, const int32_t& maxRangeX /*= 0*/,
+                               const int32_t& minRangeY /*= 0*/, const int32_t& maxRangeY /*= 0*/)
+{
+	map->getSpectators(list, centerPos, checkforduplicate, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY, true);
+}
+
+const SpectatorVec& Game::getPlayerSpectators(const Position& centerPos)
+{
+	return map->getSpectators(centerPos, true);
+}
+
 void Game::clearSpectatorCache()
 {
 	if (map)
@@ -5557,6 +5709,14 @@ void Game::clearSpectatorCache()
 	}
 }
 
+void Game::clearSightCache()
+{
+	if (map)
+	{
+		map->clearSightCache();
+	}
+}
+
 bool Game::cancelRuleViolation(Player* player)
 {
 	RuleViolationsMap::iterator it = ruleViolations.find(player->getID());
@@ -5627,6 +5787,7 @@ void Game::shutdown()
 	std::cout << "Shutting down server...";
 	g_scheduler.shutdown();
 	g_dispatcher.shutdown();
+	IOPlayer::instance()->stopSaveThread();
 	Spawns::getInstance()->clear();
 	Raids::getInstance()->clear();
 	cleanup();
@@ -280,6 +280,10 @@ public:
 	uint32_t getMonstersOnline() const;
 	uint32_t getNpcsOnline() const;
 	uint32_t getCreaturesOnline() const;
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	size_t getCheckCreatureCount(const uint32_t& bucket) const;
+	const int64_t& getCheckCreatureTime(const uint32_t& bucket) const;
+#endif
 
 	void getWorldLightInfo(LightInfo& lightInfo);
 
@@ -288,7 +292,14 @@ public:
 	                   const int32_t& minRangeX = 0, const int32_t& maxRangeX = 0,
 	                   const int32_t& minRangeY = 0, const int32_t& maxRangeY = 0);
 	const SpectatorVec& getSpectators(const Position& centerPos);
+	// same as above, but only players are returned
+	void getPlayerSpectators(SpectatorVec& list, const Position& centerPos,
+	                         bool checkforduplicate = false, bool multifloor = false,
+	                         const int32_t& minRangeX = 0, const int32_t& maxRangeX = 0,
+	                         const int32_t& minRangeY = 0, const int32_t& maxRangeY = 0);
+	const SpectatorVec& getPlayerSpectators(const Position& centerPos);
 	void clearSpectatorCache();
+	void clearSightCache();
 
 	ReturnValue internalMoveCreature(Creature* creature, const Direction& direction, const uint32_t& flags = 0);
 	ReturnValue internalMoveCreature(Creature* creature, Cylinder* fromCylinder,
@@ -509,6 +520,11 @@ public:
 	GameState_t getGameState();
 	void setGameState(const GameState_t& newState);
 	bool saveServer(bool payHouses, bool shallowSave = false);
+	void checkPlayerSaves();
+	uint32_t getPlayerSaveBacklog() const
+	{
+		return (uint32_t)playerSaveQueue.size();
+	}
 	void saveGameState();
 	void loadGameState();
 	void refreshMap(Map::TileMap::iterator* begin = NULL, int clean_max = 0);
@@ -573,6 +589,12 @@ protected:
 	uint32_t checkLightEvent;
 	uint32_t checkCreatureEvent;
 	uint32_t checkDecayEvent;
+	uint32_t checkPlayerSaveEvent;
+
+	//players waiting to be snapshotted by checkPlayerSaves, with their shallow flag
+	typedef std::list<std::pair<uint32_t, bool> > PlayerSaveQueue;
+	PlayerSaveQueue playerSaveQueue;
+	int64_t playerSaveStart;
 
 	//list of items that are in trading state, mapped to the player
 	std::map<Item*, uint32_t> tradeItems;
@@ -581,9 +603,25 @@ protected:
 	RuleViolationsMap ruleViolations;
 
 	AutoList<Creature> listCreature;
+
+	//name indexes, keyed by the upper case name
+	typedef std::unordered_map<std::string, std::vector<Creature*> > CreatureNameMap;
+	typedef std::unordered_map<std::string, Player*> PlayerNameMap;
+	typedef std::map<std::string, Player*> PlayerPrefixMap;
+	CreatureNameMap creatureNameIndex;
+	PlayerNameMap playerNameIndex;
+	PlayerPrefixMap playerPrefixIndex;
+
+	void addCreatureName(Creature* creature);
+	void removeCreatureName(Creature* creature);
+
 	size_t checkCreatureLastIndex;
 	std::vector<Creature*> checkCreatureVectors[EVENT_CREATURECOUNT];
 	std::vector<Creature*> toAddCheckCreatureVector;
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	// microseconds the last check of each vector took
+	int64_t checkCreatureTimes[EVENT_CREATURECOUNT];
+#endif
 
 	struct GameEvent
 	{
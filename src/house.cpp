@@ -35,6 +35,9 @@ extern ConfigManager g_config;
 extern Game g_game;
 extern Guilds g_guilds;
 
+// players whose pattern decision an access list remembers before it starts over
+#define ACCESSLIST_CACHE_SIZE 1024
+
 House::House(const uint32_t& _id)
 	: transfer_container(ITEM_LOCKER1)
 {
@@ -777,7 +780,8 @@ bool AccessList::parseList(const std::string& _list)
 	playerList.clear();
 	guildList.clear();
 	expressionList.clear();
-	regExList.clear();
+	patternList.clear();
+	patternCache.clear();
 	list = _list;
 
 	if (_list == "")
@@ -879,79 +883,126 @@ bool AccessList::addExpression(const std::string& expression)
 		}
 	}
 
-	std::string outExp;
-	std::string metachars = ".[{}()\\+|^$";
+	expressionList.push_back(expression);
 
-	for (std::string::const_iterator it = expression.begin(); it != expression.end(); ++it)
+	if (expression.substr(0, 1) == "!")
 	{
-		if (metachars.find(*it) != std::string::npos)
+		if (expression.length() > 1)
 		{
-			outExp += "\\";
+			//push 'NOT' expressions upfront so they are checked first
+			patternList.push_front(std::make_pair(expression.substr(1), false));
 		}
+	}
+	else
+	{
+		patternList.push_back(std::make_pair(expression, true));
+	}
+
+	return true;
+}
 
-		outExp += (*it);
+bool AccessList::matchPattern(const std::string& pattern, const std::string& name)
+{
+	// '*' stands for any text and '?' for one character or none, every
+	// other character for itself. states[i] tells whether the first i
+	// characters of the pattern can match the name read so far.
+	bool states[101];
+	bool next[101];
+	size_t length = pattern.length();
+
+	if (length > 100)
+	{
+		return false;
 	}
 
-	replaceString(outExp, "*", ".*");
-	replaceString(outExp, "?", ".?");
+	std::fill(states, states + length + 1, false);
+	states[0] = true;
 
-	try
+	for (size_t n = 0; ; ++n)
 	{
-		if (outExp.length() > 0)
+		for (size_t i = 0; i < length; ++i)
 		{
-			expressionList.push_back(outExp);
+			if (states[i] && (pattern[i] == '*' || pattern[i] == '?'))
+			{
+				states[i + 1] = true;
+			}
+		}
 
-			if (outExp.substr(0, 1) == "!")
+		if (n == name.length())
+		{
+			return states[length];
+		}
+
+		char c = tolower(name[n]);
+		bool alive = false;
+		std::fill(next, next + length + 1, false);
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (!states[i])
 			{
-				if (outExp.length() > 1)
-				{
-					//push 'NOT' expressions upfront so they are checked first
-					regExList.push_front(std::make_pair(boost::regex(outExp.substr(1)), false));
-				}
+				continue;
 			}
-			else
+
+			if (pattern[i] == '*')
+			{
+				next[i] = alive = true;
+			}
+			else if (pattern[i] == '?' || pattern[i] == c)
 			{
-				regExList.push_back(std::make_pair(boost::regex(outExp), true));
+				next[i + 1] = alive = true;
 			}
 		}
+
+		if (!alive)
+		{
+			return false;
+		}
+
+		std::copy(next, next + length + 1, states);
 	}
-	catch (...)
+}
+
+AccessList::PatternResult_t AccessList::matchPatterns(const Player* player)
+{
+	PatternCache::iterator it = patternCache.find(player->getGUID());
+
+	if (it != patternCache.end())
 	{
-		//
+		return it->second;
 	}
 
-	return true;
+	PatternResult_t result = PATTERN_NOMATCH;
+
+	for (PatternList::iterator pit = patternList.begin(); pit != patternList.end(); ++pit)
+	{
+		if (matchPattern(pit->first, player->getName()))
+		{
+			result = (pit->second ? PATTERN_ALLOW : PATTERN_DENY);
+			break;
+		}
+	}
+
+	if (patternCache.size() >= ACCESSLIST_CACHE_SIZE)
+	{
+		patternCache.clear();
+	}
+
+	patternCache[player->getGUID()] = result;
+	return result;
 }
 
 bool AccessList::isInList(const Player* player)
 {
-	RegExList::iterator it;
-	std::string name = player->getName();
-	boost::cmatch what;
-
-	try
+	if (!patternList.empty())
 	{
-		std::transform(name.begin(), name.end(), name.begin(), tolower);
+		PatternResult_t result = matchPatterns(player);
 
-		for (it = regExList.begin(); it != regExList.end(); ++it)
+		if (result != PATTERN_NOMATCH)
 		{
-			if (boost::regex_match(name.c_str(), what, it->first))
-			{
-				if (it->second)
-				{
-					return true;
-				}
-				else
-				{
-					return false;
-				}
-			}
+			return result == PATTERN_ALLOW;
 		}
 	}
-	catch (...)
-	{
-		//
-	}
 
 	PlayerList::iterator playerIt = playerList.find(player->getGUID());
 
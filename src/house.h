@@ -25,7 +25,6 @@
 #include "position.h"
 #include "housetile.h"
 #include "player.h"
-#include <boost/regex.hpp>
 #include <string>
 #include <list>
 #include <map>
@@ -50,12 +49,28 @@ private:
 	typedef std::list< std::pair<uint32_t, std::string> > GuildList;
 
 	typedef std::list<std::string> ExpressionList;
-	typedef std::list<std::pair<boost::regex, bool> > RegExList;
+	// wildcard patterns, false for the 'NOT' ones
+	typedef std::list<std::pair<std::string, bool> > PatternList;
+
+	enum PatternResult_t
+	{
+		PATTERN_NOMATCH,
+		PATTERN_ALLOW,
+		PATTERN_DENY
+	};
+
+	// what the patterns decided for a player, names do not change online
+	typedef std::unordered_map<uint32_t, PatternResult_t> PatternCache;
+
+	static bool matchPattern(const std::string& pattern, const std::string& name);
+	PatternResult_t matchPatterns(const Player* player);
+
 	std::string list;
 	PlayerList playerList;
 	GuildList guildList;
 	ExpressionList expressionList;
-	RegExList regExList;
+	PatternList patternList;
+	PatternCache patternCache;
 };
 
 class House;
@@ -507,6 +507,7 @@ bool IOMapOTBM::loadMap(Map* map, const std::string& identifier)
 					}
 
 					tile->setFlag((tileflags_t)tileflags);
+					tile->packItems();
 					map->setTile(px, py, pz, tile);
 				}
 				else
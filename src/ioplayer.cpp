@@ -27,6 +27,7 @@
 #include "tools.h"
 #include "guild.h"
 #include "game.h"
+#include "otsystem.h"
 #include <iostream>
 #include <iomanip>
 
@@ -300,6 +301,8 @@ bool IOPlayer::loadPlayer(Player* player, const std::string& name, bool preload
 		db->freeResult(result);
 	}
 
+	//everything matches the database now
+	player->clearSaveDirty();
 	player->updateBaseSpeed();
 	player->updateInventoryWeight();
 	player->updateItemsLight(true);
@@ -565,6 +568,8 @@ bool IOPlayer::loadPlayer(Player* player, const std::string& name, bool preload
 		db->freeResult(result);
 	}
 
+	//everything matches the database now
+	player->clearSaveDirty();
 	player->updateBaseSpeed();
 	player->updateInventoryWeight();
 	player->updateItemsLight(true);
@@ -803,12 +808,255 @@ bool IOPlayer::saveItems(Player* player, const ItemBlockList& itemList, DBInsert
 
 bool IOPlayer::savePlayer(Player* player, bool shallow)
 {
-	player->preSave();
+	//holding the database lock keeps the save thread from writing an older
+	//queued snapshot of this player after this one
+	DBQuery lock;
+
+	if (cancelPlayerSave(player))
+	{
+		shallow = false;
+	}
+
+	PlayerSaveJob job;
+
+	if (!preparePlayerSave(player, shallow, job))
+	{
+		return false;
+	}
+
+	if (!executePlayerSave(job))
+	{
+		boost::mutex::scoped_lock lockClass(m_saveLock);
+		m_failedSaves.insert(job.guid);
+		return false;
+	}
+
+	return true;
+}
+
+bool IOPlayer::queuePlayerSave(Player* player, bool shallow)
+{
+	PlayerSaveJob* job = new PlayerSaveJob;
+
+	if (!preparePlayerSave(player, shallow, *job))
+	{
+		delete job;
+		return false;
+	}
+
+	m_saveLock.lock();
+
+	if (!m_saveThreadRunning)
+	{
+		m_saveLock.unlock();
+		bool ret = executePlayerSave(*job);
+
+		if (!ret)
+		{
+			boost::mutex::scoped_lock lockClass(m_saveLock);
+			m_failedSaves.insert(job->guid);
+		}
+
+		delete job;
+		return ret;
+	}
+
+	bool do_signal = m_saveList.empty();
+	m_saveList.push_back(job);
+	m_saveLock.unlock();
+
+	if (do_signal)
+	{
+		m_saveSignal.notify_one();
+	}
+
+	return true;
+}
+
+bool IOPlayer::cancelPlayerSave(Player* player)
+{
+	boost::mutex::scoped_lock lockClass(m_saveLock);
+	bool hadFullSave = false;
+
+	for (std::list<PlayerSaveJob*>::iterator it = m_saveList.begin(); it != m_saveList.end();)
+	{
+		if ((*it)->guid == player->getGUID())
+		{
+			//the dropped sections have to be written by the next save instead
+			hadFullSave = hadFullSave || !(*it)->shallow;
+			player->setSaveDirty((*it)->sections);
+			delete *it;
+			it = m_saveList.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	//the dropped job may have been the last one of the server save
+	if (m_saveList.empty() && !m_saveWriting && m_saveBatchQueued)
+	{
+		reportSaveBatch();
+	}
+
+	return hadFullSave;
+}
+
+bool IOPlayer::takeFailedSave(uint32_t guid)
+{
+	boost::mutex::scoped_lock lockClass(m_saveLock);
+	return m_failedSaves.erase(guid) != 0;
+}
+
+void IOPlayer::startSaveThread()
+{
+	boost::mutex::scoped_lock lockClass(m_saveLock);
+
+	if (!m_saveThreadRunning)
+	{
+		m_saveThreadRunning = true;
+		m_saveThread = boost::thread(boost::bind(&IOPlayer::saveThread, (void*)this));
+	}
+}
+
+void IOPlayer::stopSaveThread()
+{
+	m_saveLock.lock();
+
+	if (!m_saveThreadRunning)
+	{
+		m_saveLock.unlock();
+		return;
+	}
+
+	m_saveThreadRunning = false;
+	m_saveLock.unlock();
+	m_saveSignal.notify_one();
+	//the thread writes everything still queued before it exits
+	m_saveThread.join();
+}
+
+void IOPlayer::saveThread(void* p)
+{
+	IOPlayer* io = static_cast<IOPlayer*>(p);
+	boost::unique_lock<boost::mutex> saveLockUnique(io->m_saveLock, boost::defer_lock);
+
+	while (true)
+	{
+		saveLockUnique.lock();
+
+		while (io->m_saveList.empty() && io->m_saveThreadRunning)
+		{
+			io->m_saveSignal.wait(saveLockUnique);
+		}
+
+		if (io->m_saveList.empty())
+		{
+			saveLockUnique.unlock();
+			break;
+		}
+
+		saveLockUnique.unlock();
+		//take the database lock before picking the job, see savePlayer
+		DBQuery lock;
+		PlayerSaveJob* job = NULL;
+		saveLockUnique.lock();
+
+		if (!io->m_saveList.empty())
+		{
+			job = io->m_saveList.front();
+			io->m_saveList.pop_front();
+			io->m_saveWriting = true;
+		}
+
+		saveLockUnique.unlock();
+
+		if (!job)
+		{
+			continue;
+		}
+
+		uint32_t guid = job->guid;
+		int64_t start = OTSYS_TIME();
+		bool ret = io->executePlayerSave(*job);
+		int64_t duration = OTSYS_TIME() - start;
+		delete job;
+		saveLockUnique.lock();
+		io->m_saveWriting = false;
+
+		if (ret)
+		{
+			io->m_saveStats.saved++;
+			io->m_batchStats.saved++;
+		}
+		else
+		{
+			io->m_saveStats.failed++;
+			io->m_batchStats.failed++;
+			io->m_failedSaves.insert(guid);
+		}
+
+		io->m_saveStats.lastWriteTime = duration;
+		io->m_saveStats.totalWriteTime += duration;
+		io->m_batchStats.totalWriteTime += duration;
+
+		if (duration > io->m_saveStats.maxWriteTime)
+		{
+			io->m_saveStats.maxWriteTime = duration;
+		}
+
+		if (duration > io->m_batchStats.maxWriteTime)
+		{
+			io->m_batchStats.maxWriteTime = duration;
+		}
+
+		if (io->m_saveList.empty() && io->m_saveBatchQueued)
+		{
+			io->reportSaveBatch();
+		}
+
+		saveLockUnique.unlock();
+	}
+}
+
+void IOPlayer::finishSaveBatch()
+{
+	boost::mutex::scoped_lock lockClass(m_saveLock);
+	m_saveBatchQueued = true;
+
+	//the save thread may already be done with all of them
+	if (m_saveList.empty() && !m_saveWriting)
+	{
+		reportSaveBatch();
+	}
+}
+
+void IOPlayer::reportSaveBatch()
+{
+	//m_saveLock is held by the caller
+	std::cout << "Notice: Save thread wrote " << m_batchStats.saved << " players ("
+	          << m_batchStats.failed << " failed) in " << m_batchStats.totalWriteTime / (1000.)
+	          << "s, slowest took " << m_batchStats.maxWriteTime << "ms." << std::endl;
+	m_batchStats = PlayerSaveStats();
+	m_saveBatchQueued = false;
+}
+
+IOPlayer::PlayerSaveStats IOPlayer::getSaveStats()
+{
+	boost::mutex::scoped_lock lockClass(m_saveLock);
+	PlayerSaveStats stats = m_saveStats;
+	stats.pending = (uint32_t)m_saveList.size();
+	return stats;
+}
+
+bool IOPlayer::executePlayerSave(const PlayerSaveJob& job)
+{
 	Database* db = Database::instance();
 	DBQuery query;
 	DBResult* result;
 	//check if the player has to be saved or not
-	query << "SELECT `save` FROM `players` WHERE `id` = " << player->getGUID();
+	query << "SELECT `save` FROM `players` WHERE `id` = " << job.guid;
 
 	if (!(result = db->storeQuery(query.str())))
 	{
@@ -824,6 +1072,50 @@ bool IOPlayer::savePlayer(Player* player, bool shallow)
 		return true;
 	}
 
+	DBTransaction transaction(db);
+
+	if (!transaction.begin())
+	{
+		return false;
+	}
+
+	for (std::vector<std::string>::const_iterator it = job.queries.begin(); it != job.queries.end(); ++it)
+	{
+		if (!db->executeQuery(*it))
+		{
+			return false;
+		}
+	}
+
+	return transaction.commit();
+}
+
+bool IOPlayer::preparePlayerSave(Player* player, bool shallow, PlayerSaveJob& job)
+{
+	player->preSave();
+	job.guid = player->getGUID();
+	job.shallow = shallow;
+	Database* db = Database::instance();
+	DBQuery query;
+
+	//only the sections that changed since the last save are rewritten
+	uint32_t sections = player->saveSections;
+
+	for (DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+	{
+		if (it->second->isSaveDirty())
+		{
+			sections |= PLAYERSAVE_DEPOTS;
+		}
+	}
+
+	if (takeFailedSave(job.guid))
+	{
+		sections = PLAYERSAVE_ALL;
+	}
+
+	job.sections = sections;
+
 	//serialize conditions
 	PropWriteStream propWriteStream;
 
@@ -842,6 +1134,8 @@ bool IOPlayer::savePlayer(Player* player, bool shallow)
 
 	uint32_t conditionsSize;
 	const char* conditions = propWriteStream.getStream(conditionsSize);
+	//persistent conditions tick, so they are written whenever there are any
+	bool saveConditions = conditionsSize > 0 || (sections & PLAYERSAVE_CONDITIONS) != 0;
 	//First, an UPDATE query to write the player itself
 	query.str("");
 	query << "UPDATE `players` SET `level` = " << player->level
@@ -867,7 +1161,6 @@ bool IOPlayer::savePlayer(Player* player, bool shallow)
 	      << ", `posz` = " << player->getLoginPosition().z
 	      << ", `cap` = " << player->getCapacity()
 	      << ", `sex` = " << player->sex
-	      << ", `conditions` = " << db->escapeBlob(conditions, conditionsSize)
 	      << ", `loss_experience` = " << (int32_t)player->getLossPercent(LOSS_EXPERIENCE)
 	      << ", `loss_mana` = " << (int32_t)player->getLossPercent(LOSS_MANASPENT)
 	      << ", `loss_skills` = " << (int32_t)player->getLossPercent(LOSS_SKILLTRIES)
@@ -876,184 +1169,168 @@ bool IOPlayer::savePlayer(Player* player, bool shallow)
 	      << ", `balance` = " << player->balance
 	      << ", `stamina` = " << player->stamina
 	      << ", `skull_type` = " << (player->getSkull() == SKULL_RED || player->getSkull() == SKULL_BLACK ? player->getSkull() : 0)
-	      << ", `skull_time` = " << player->lastSkullTime
-	      << " WHERE `id` = " << player->getGUID();
-	DBTransaction transaction(db);
-
-	if (!transaction.begin())
-	{
-		return false;
-	}
+	      << ", `skull_time` = " << player->lastSkullTime;
 
-	if (!db->executeQuery(query.str()))
+	if (saveConditions)
 	{
-		return false;
+		query << ", `conditions` = " << db->escapeBlob(conditions, conditionsSize);
 	}
 
+	query << " WHERE `id` = " << player->getGUID();
+	job.queries.push_back(query.str());
 	query.str("");
 
 	//skills
-	for (int32_t i = 0; i <= 6; ++i)
+	if (sections & PLAYERSAVE_SKILLS)
 	{
-		query << "UPDATE `player_skills` SET `value` = " << player->skills[i][SKILL_LEVEL] << ", `count` = " << player->skills[i][SKILL_TRIES] << " WHERE `player_id` = " << player->getGUID() << " AND `skillid` = " << i;
-
-		if (!db->executeQuery(query.str()))
+		for (int32_t i = 0; i <= 6; ++i)
 		{
-			return false;
+			query << "UPDATE `player_skills` SET `value` = " << player->skills[i][SKILL_LEVEL] << ", `count` = " << player->skills[i][SKILL_TRIES] << " WHERE `player_id` = " << player->getGUID() << " AND `skillid` = " << i;
+			job.queries.push_back(query.str());
+			query.str("");
 		}
-
-		query.str("");
 	}
 
 	if (shallow)
 	{
-		return transaction.commit();
-	}
-
-	// deletes all player-related stuff
-	query << "DELETE FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-
-	if (!db->executeQuery(query.str()))
-	{
-		return false;
-	}
-
-	query.str("");
-	query << "DELETE FROM `player_items` WHERE `player_id` = " << player->getGUID();
-
-	if (!db->executeQuery(query.str()))
-	{
-		return false;
-	}
-
-	query.str("");
-	query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();
-
-	if (!db->executeQuery(query.str()))
-	{
-		return false;
-	}
-
-	query.str("");
-	query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-
-	if (!db->executeQuery(query.str()))
-	{
-		return false;
+		player->saveSections &= ~(PLAYERSAVE_SKILLS | PLAYERSAVE_CONDITIONS);
+		return true;
 	}
 
-	query.str("");
-	query << "DELETE FROM `player_viplist` WHERE `player_id` = " << player->getGUID();
+	DBInsert stmt(db);
+	stmt.setQueryList(&job.queries);
 
-	if (!db->executeQuery(query.str()))
+	//learned spells
+	if (sections & PLAYERSAVE_SPELLS)
 	{
-		return false;
-	}
+		query << "DELETE FROM `player_spells` WHERE `player_id` = " << player->getGUID();
+		job.queries.push_back(query.str());
+		query.str("");
+		stmt.setQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
 
-	query.str("");
-	DBInsert stmt(db);
-	//learned spells
-	stmt.setQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
+		for (LearnedInstantSpellList::const_iterator it = player->learnedInstantSpellList.begin();
+		        it != player->learnedInstantSpellList.end(); ++it)
+		{
+			query << player->getGUID() << ", " << db->escapeString(*it);
 
-	for (LearnedInstantSpellList::const_iterator it = player->learnedInstantSpellList.begin();
-	        it != player->learnedInstantSpellList.end(); ++it)
-	{
-		query << player->getGUID() << ", " << db->escapeString(*it);
+			if (!stmt.addRow(query))
+			{
+				return false;
+			}
+		}
 
-		if (!stmt.addRow(query))
+		if (!stmt.execute())
 		{
 			return false;
 		}
 	}
 
-	if (!stmt.execute())
-	{
-		return false;
-	}
-
 	ItemBlockList itemList;
 	Item* item;
 
-	for (int32_t slotId = 1; slotId <= 10; ++slotId)
+	//item saving
+	if (sections & PLAYERSAVE_INVENTORY)
 	{
-		if ((item = player->inventory[slotId]))
+		query << "DELETE FROM `player_items` WHERE `player_id` = " << player->getGUID();
+		job.queries.push_back(query.str());
+		query.str("");
+
+		for (int32_t slotId = 1; slotId <= 10; ++slotId)
 		{
-			itemList.push_back(itemBlock(slotId, item));
+			if ((item = player->inventory[slotId]))
+			{
+				itemList.push_back(itemBlock(slotId, item));
+			}
 		}
-	}
-
-	//item saving
-	stmt.setQuery("INSERT INTO `player_items` (`player_id` , `pid` , `sid` , `itemtype` , `count` , `attributes` ) VALUES ");
 
-	if (!(saveItems(player, itemList, stmt) && stmt.execute()))
-	{
-		return false;
-	}
+		stmt.setQuery("INSERT INTO `player_items` (`player_id` , `pid` , `sid` , `itemtype` , `count` , `attributes` ) VALUES ");
 
-	itemList.clear();
+		if (!(saveItems(player, itemList, stmt) && stmt.execute()))
+		{
+			return false;
+		}
 
-	for (DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
-	{
-		itemList.push_back(itemBlock(it->first, it->second));
+		itemList.clear();
 	}
 
 	//save depot items
-	stmt.setQuery("INSERT INTO `player_depotitems` (`player_id` , `pid` , `sid` , `itemtype` , `count` , `attributes` ) VALUES ");
-
-	if (!(saveItems(player, itemList, stmt) && stmt.execute()))
+	if (sections & PLAYERSAVE_DEPOTS)
 	{
-		return false;
-	}
+		query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();
+		job.queries.push_back(query.str());
+		query.str("");
 
-	stmt.setQuery("INSERT INTO `player_storage` (`player_id` , `key` , `value` ) VALUES ");
-	player->genReservedStorageRange();
+		for (DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+		{
+			itemList.push_back(itemBlock(it->first, it->second));
+		}
 
-	for (StorageMap::const_iterator cit = player->getStorageIteratorBegin(); cit != player->getStorageIteratorEnd(); ++cit)
-	{
-		query << player->getGUID() << ", " << cit->first << ", " << cit->second;
+		stmt.setQuery("INSERT INTO `player_depotitems` (`player_id` , `pid` , `sid` , `itemtype` , `count` , `attributes` ) VALUES ");
 
-		if (!stmt.addRow(query))
+		if (!(saveItems(player, itemList, stmt) && stmt.execute()))
 		{
 			return false;
 		}
 	}
 
-	if (!stmt.execute())
-	{
-		return false;
-	}
-
-	//save vip list
-	if (!player->VIPList.empty())
+	if (sections & PLAYERSAVE_STORAGE)
 	{
-		query << "INSERT INTO `player_viplist` (`player_id`, `vip_id`) SELECT " << player->getGUID()
-		      << ", `id` FROM `players` WHERE `id` IN (";
+		query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
+		job.queries.push_back(query.str());
+		query.str("");
+		stmt.setQuery("INSERT INTO `player_storage` (`player_id` , `key` , `value` ) VALUES ");
+		player->genReservedStorageRange();
 
-		for (VIPListSet::iterator it = player->VIPList.begin(); it != player->VIPList.end();)
+		for (StorageMap::const_iterator cit = player->getStorageIteratorBegin(); cit != player->getStorageIteratorEnd(); ++cit)
 		{
-			query << (*it);
-			++it;
+			query << player->getGUID() << ", " << cit->first << ", " << cit->second;
 
-			if (it != player->VIPList.end())
-			{
-				query << ",";
-			}
-			else
+			if (!stmt.addRow(query))
 			{
-				query << ")";
+				return false;
 			}
 		}
 
-		if (!db->executeQuery(query.str()))
+		if (!stmt.execute())
 		{
 			return false;
 		}
+	}
 
+	//save vip list
+	if (sections & PLAYERSAVE_VIP)
+	{
+		query << "DELETE FROM `player_viplist` WHERE `player_id` = " << player->getGUID();
+		job.queries.push_back(query.str());
 		query.str("");
+
+		if (!player->VIPList.empty())
+		{
+			query << "INSERT INTO `player_viplist` (`player_id`, `vip_id`) SELECT " << player->getGUID()
+			      << ", `id` FROM `players` WHERE `id` IN (";
+
+			for (VIPListSet::iterator it = player->VIPList.begin(); it != player->VIPList.end();)
+			{
+				query << (*it);
+				++it;
+
+				if (it != player->VIPList.end())
+				{
+					query << ",";
+				}
+				else
+				{
+					query << ")";
+				}
+			}
+
+			job.queries.push_back(query.str());
+			query.str("");
+		}
 	}
 
-	//End the transaction
-	return transaction.commit();
+	player->clearSaveDirty();
+	return true;
 }
 
 bool IOPlayer::storeNameByGuid(Database& db, uint32_t guid)
@@ -25,6 +25,9 @@
 #include "player.h"
 #include "database.h"
 #include <string>
+#include <vector>
+#include <set>
+#include <boost/thread.hpp>
 
 enum UnjustKillPeriod_t
 {
@@ -40,9 +43,34 @@ typedef std::list<itemBlock> ItemBlockList;
 class IOPlayer
 {
 public:
-	IOPlayer() {}
+	IOPlayer()
+	{
+		m_saveThreadRunning = false;
+		m_saveWriting = false;
+		m_saveBatchQueued = false;
+	}
 	~IOPlayer() {}
 
+	struct PlayerSaveStats
+	{
+		uint32_t saved;
+		uint32_t failed;
+		uint32_t pending;
+		int64_t lastWriteTime;
+		int64_t maxWriteTime;
+		int64_t totalWriteTime;
+
+		PlayerSaveStats()
+		{
+			saved = 0;
+			failed = 0;
+			pending = 0;
+			lastWriteTime = 0;
+			maxWriteTime = 0;
+			totalWriteTime = 0;
+		}
+	};
+
 	static IOPlayer* instance()
 	{
 		static IOPlayer instance;
@@ -63,6 +91,20 @@ public:
 	  */
 	bool savePlayer(Player* player, bool shallow = false);
 
+	/** Snapshot a player and let the save thread write it
+	  * \param player the player to save
+	  * \return true if the player was successfully queued
+	  */
+	bool queuePlayerSave(Player* player, bool shallow = false);
+
+	void startSaveThread();
+	void stopSaveThread();
+	PlayerSaveStats getSaveStats();
+	/** Every player of the running server save has been queued, its summary
+	  * is printed once the save thread wrote them
+	  */
+	void finishSaveBatch();
+
 	bool addPlayerDeath(Player* dying_player, const DeathList& dl);
 	int32_t getPlayerUnjustKillCount(const Player* player, UnjustKillPeriod_t period);
 
@@ -82,6 +124,21 @@ public:
 protected:
 	bool storeNameByGuid(Database& mysql, uint32_t guid);
 
+	struct PlayerSaveJob
+	{
+		uint32_t guid;
+		bool shallow;
+		uint32_t sections;
+		std::vector<std::string> queries;
+	};
+
+	bool preparePlayerSave(Player* player, bool shallow, PlayerSaveJob& job);
+	bool executePlayerSave(const PlayerSaveJob& job);
+	bool cancelPlayerSave(Player* player);
+	bool takeFailedSave(uint32_t guid);
+
+	static void saveThread(void* p);
+
 	struct StringCompareCase
 	{
 		bool operator()(const std::string& l, const std::string& r) const
@@ -139,6 +196,21 @@ protected:
 	GuidCacheMap guidCacheMap;
 	UnjustCacheMap unjustKillCacheMap;
 
+	boost::mutex m_saveLock;
+	boost::condition_variable m_saveSignal;
+	boost::thread m_saveThread;
+	bool m_saveThreadRunning;
+	std::list<PlayerSaveJob*> m_saveList;
+	//players whose last write failed, their next save rewrites every section
+	std::set<uint32_t> m_failedSaves;
+	//totals since startup
+	PlayerSaveStats m_saveStats;
+	//the counters of the running server save
+	PlayerSaveStats m_batchStats;
+	bool m_saveWriting;
+	bool m_saveBatchQueued;
+
+	void reportSaveBatch();
 };
 
 #endif
@@ -43,25 +43,56 @@ extern Weapons* g_weapons;
 ItemAttributes::ItemAttributes()
 {
 	m_attributes = 0;
-	m_firstAttr = NULL;
+	m_actionId = 0;
+	m_uniqueId = 0;
+	m_charges = 0;
+	m_extra = NULL;
 }
 
 ItemAttributes::ItemAttributes(const ItemAttributes& i)
 {
-	m_attributes = i.m_attributes;
-
-	if (i.m_firstAttr)
-	{
-		m_firstAttr = new Attribute(*i.m_firstAttr);
-	}
+	m_attributes = 0;
+	m_actionId = 0;
+	m_uniqueId = 0;
+	m_charges = 0;
+	m_extra = NULL;
+	*this = i;
 }
 
 ItemAttributes::~ItemAttributes()
 {
-	if (m_firstAttr)
+	deleteAttrs();
+}
+
+ItemAttributes& ItemAttributes::operator=(const ItemAttributes& i)
+{
+	if (this == &i)
 	{
-		deleteAttrs(m_firstAttr);
+		return *this;
 	}
+
+	deleteAttrs();
+	m_attributes = i.m_attributes;
+	m_actionId = i.m_actionId;
+	m_uniqueId = i.m_uniqueId;
+	m_charges = i.m_charges;
+
+	if (i.m_extra)
+	{
+		m_extra = new ExtraAttributes(*i.m_extra);
+
+		if (i.m_extra->strings)
+		{
+			m_extra->strings = new std::string[STR_ATTR_LAST];
+
+			for (int32_t n = 0; n < STR_ATTR_LAST; ++n)
+			{
+				m_extra->strings[n] = i.m_extra->strings[n];
+			}
+		}
+	}
+
+	return *this;
 }
 
 void ItemAttributes::setSpecialDescription(const std::string& desc)
@@ -106,7 +137,7 @@ void ItemAttributes::resetWrittenDate()
 
 time_t ItemAttributes::getWrittenDate() const
 {
-	return (time_t)getIntAttr(ATTR_ITEM_WRITTENDATE);
+	return (time_t)(uint32_t)getExtraAttr(EXTRA_ATTR_WRITTENDATE);
 }
 
 void ItemAttributes::setWriter(const std::string& _writer)
@@ -129,41 +160,21 @@ void ItemAttributes::setActionId(const uint16_t& n)
 	setIntAttr(ATTR_ITEM_ACTIONID, n > 100 ? n : 100);
 }
 
-uint16_t ItemAttributes::getActionId() const
-{
-	return (uint16_t)getIntAttr(ATTR_ITEM_ACTIONID);
-}
-
 void ItemAttributes::setUniqueId(const uint16_t& n)
 {
 	setIntAttr(ATTR_ITEM_UNIQUEID, n > 1000 ? n : 1000);
 }
 
-uint16_t ItemAttributes::getUniqueId() const
-{
-	return (uint16_t)getIntAttr(ATTR_ITEM_UNIQUEID);
-}
-
 void ItemAttributes::setCharges(const uint16_t& n)
 {
 	setIntAttr(ATTR_ITEM_CHARGES, n);
 }
 
-uint16_t ItemAttributes::getCharges() const
-{
-	return (uint16_t)getIntAttr(ATTR_ITEM_CHARGES);
-}
-
 void ItemAttributes::setFluidType(const uint16_t& n)
 {
 	setIntAttr(ATTR_ITEM_FLUIDTYPE, n);
 }
 
-uint16_t ItemAttributes::getFluidType() const
-{
-	return (uint16_t)getIntAttr(ATTR_ITEM_FLUIDTYPE);
-}
-
 void ItemAttributes::setOwner(const uint32_t& _owner)
 {
 	setIntAttr(ATTR_ITEM_OWNER, _owner);
@@ -171,7 +182,7 @@ void ItemAttributes::setOwner(const uint32_t& _owner)
 
 uint32_t ItemAttributes::getOwner() const
 {
-	return (uint32_t)getIntAttr(ATTR_ITEM_OWNER);
+	return (uint32_t)getExtraAttr(EXTRA_ATTR_OWNER);
 }
 
 void ItemAttributes::setCorpseOwner(const uint32_t& _corpseOwner)
@@ -181,7 +192,7 @@ void ItemAttributes::setCorpseOwner(const uint32_t& _corpseOwner)
 
 uint32_t ItemAttributes::getCorpseOwner()
 {
-	return (uint32_t)getIntAttr(ATTR_ITEM_CORPSEOWNER);
+	return (uint32_t)getExtraAttr(EXTRA_ATTR_CORPSEOWNER);
 }
 
 void ItemAttributes::setDuration(const int32_t& time)
@@ -194,21 +205,11 @@ void ItemAttributes::decreaseDuration(const int32_t& time)
 	increaseIntAttr(ATTR_ITEM_DURATION, -time);
 }
 
-int32_t ItemAttributes::getDuration() const
-{
-	return (int32_t)getIntAttr(ATTR_ITEM_DURATION);
-}
-
 void ItemAttributes::setDecaying(const ItemDecayState_t& decayState)
 {
 	setIntAttr(ATTR_ITEM_DECAYING, decayState);
 }
 
-uint32_t ItemAttributes::getDecaying() const
-{
-	return (uint32_t)getIntAttr(ATTR_ITEM_DECAYING);
-}
-
 bool ItemAttributes::hasAttribute(const itemAttrTypes& type) const
 {
 	if (!validateIntAttrType(type))
@@ -216,56 +217,46 @@ bool ItemAttributes::hasAttribute(const itemAttrTypes& type) const
 		return false;
 	}
 
-	Attribute* attr = getAttrConst(type);
-
-	if (attr)
-	{
-		return true;
-	}
-
-	return false;
+	return (m_attributes & type) != 0;
 }
 
 void ItemAttributes::removeAttribute(const itemAttrTypes& type)
 {
 	//check if we have it
-	if ((type & m_attributes) != 0)
+	if ((type & m_attributes) == 0)
 	{
-		//go trough the linked list until find it
-		Attribute* prevAttr = NULL;
-		Attribute* curAttr = m_firstAttr;
-
-		while (curAttr)
-		{
-			if (curAttr->type == type)
-			{
-				//found so remove it from the linked list
-				if (prevAttr)
-				{
-					prevAttr->next = curAttr->next;
-				}
-				else
-				{
-					m_firstAttr = curAttr->next;
-				}
+		return;
+	}
 
-				//remove it from flags
-				m_attributes = m_attributes & ~type;
+	//remove it from flags and reset its value
+	m_attributes = m_attributes & ~type;
 
-				//delete string if it is string type
-				if (validateStrAttrType(type))
-				{
-					delete(std::string*)curAttr->value;
-				}
+	switch (type)
+	{
+		case ATTR_ITEM_ACTIONID:
+			m_actionId = 0;
+			break;
+		case ATTR_ITEM_UNIQUEID:
+			m_uniqueId = 0;
+			break;
+		case ATTR_ITEM_CHARGES:
+			m_charges = 0;
+			break;
+		default:
+		{
+			int32_t index = getExtraAttrIndex(type);
 
-				//finally delete the attribute and return
-				delete curAttr;
-				return;
+			if (index != -1)
+			{
+				m_extra->values[index] = 0;
+			}
+			else if ((index = getStrAttrIndex(type)) != -1)
+			{
+				m_extra->strings[index].clear();
 			}
 
-			//advance in the linked list
-			prevAttr = curAttr;
-			curAttr = curAttr->next;
+			releaseExtraAttrs();
+			break;
 		}
 	}
 }
@@ -274,22 +265,12 @@ const std::string& ItemAttributes::getStrAttr(const itemAttrTypes& type) const
 {
 	static const std::string EMPTY_STRING;
 
-	if (!validateStrAttrType(type))
+	if (!validateStrAttrType(type) || (type & m_attributes) == 0)
 	{
 		return EMPTY_STRING;
 	}
 
-	//this will *NOT* create the attribute if it does not exist
-	Attribute* attr = getAttrConst(type);
-
-	if (attr)
-	{
-		return *(std::string*)attr->value;
-	}
-	else
-	{
-		return EMPTY_STRING;
-	}
+	return m_extra->strings[getStrAttrIndex(type)];
 }
 
 void ItemAttributes::setStrAttr(const itemAttrTypes& type, const std::string& value)
@@ -304,54 +285,69 @@ void ItemAttributes::setStrAttr(const itemAttrTypes& type, const std::string& va
 		return;
 	}
 
-	//this will create the attribute if it does not exist
-	Attribute* attr = getAttr(type);
+	ExtraAttributes* extra = getExtraAttrs();
 
-	if (attr)
+	if (!extra->strings)
 	{
-		//if has a previous value delete it
-		if (attr->value)
-		{
-			delete(std::string*)attr->value;
-		}
-
-		//create the new value as string
-		attr->value = (void*)new std::string(value);
+		extra->strings = new std::string[STR_ATTR_LAST];
 	}
+
+	extra->strings[getStrAttrIndex(type)] = value;
+	m_attributes = m_attributes | type;
 }
 
 uint32_t ItemAttributes::getIntAttr(const itemAttrTypes& type) const
 {
-	if (!validateIntAttrType(type))
+	switch (type)
 	{
-		return 0;
-	}
+		case ATTR_ITEM_ACTIONID:
+			return m_actionId;
+		case ATTR_ITEM_UNIQUEID:
+			return m_uniqueId;
+		case ATTR_ITEM_CHARGES:
+			return m_charges;
+		default:
+		{
+			int32_t index = getExtraAttrIndex(type);
 
-	Attribute* attr = getAttrConst(type);
+			if (index == -1)
+			{
+				return 0;
+			}
 
-	if (attr)
-	{
-		return static_cast<uint32_t>(0xFFFFFFFF & reinterpret_cast<ptrdiff_t>(attr->value));
-	}
-	else
-	{
-		return 0;
+			return (uint32_t)getExtraAttr((extraAttrIndex)index);
+		}
 	}
 }
 
 void ItemAttributes::setIntAttr(const itemAttrTypes& type, const int32_t& value)
 {
-	if (!validateIntAttrType(type))
+	switch (type)
 	{
-		return;
-	}
+		case ATTR_ITEM_ACTIONID:
+			m_actionId = (uint16_t)value;
+			break;
+		case ATTR_ITEM_UNIQUEID:
+			m_uniqueId = (uint16_t)value;
+			break;
+		case ATTR_ITEM_CHARGES:
+			m_charges = (uint16_t)value;
+			break;
+		default:
+		{
+			int32_t index = getExtraAttrIndex(type);
 
-	Attribute* attr = getAttr(type);
+			if (index == -1)
+			{
+				return;
+			}
 
-	if (attr)
-	{
-		attr->value = reinterpret_cast<void*>(static_cast<ptrdiff_t>(value));
+			getExtraAttrs()->values[index] = value;
+			break;
+		}
 	}
+
+	m_attributes = m_attributes | type;
 }
 
 void ItemAttributes::increaseIntAttr(const itemAttrTypes& type, const int32_t& value)
@@ -361,12 +357,7 @@ void ItemAttributes::increaseIntAttr(const itemAttrTypes& type, const int32_t& v
 		return;
 	}
 
-	Attribute* attr = getAttr(type);
-
-	if (attr)
-	{
-		attr->value = reinterpret_cast<void*>(static_cast<ptrdiff_t>(static_cast<uint32_t>(0xFFFFFFFF & reinterpret_cast<ptrdiff_t>(attr->value)) + value));
-	}
+	setIntAttr(type, (int32_t)(getIntAttr(type) + value));
 }
 
 bool ItemAttributes::validateIntAttrType(const itemAttrTypes& type)
@@ -412,113 +403,85 @@ bool ItemAttributes::validateStrAttrType(const itemAttrTypes& type)
 	return false;
 }
 
-void ItemAttributes::addAttr(Attribute* attr)
+int32_t ItemAttributes::getExtraAttrIndex(const itemAttrTypes& type)
 {
-	//add an attribute to the linked list
-	if (m_firstAttr)
-	{
-		//is not the first, so look for the end of the list
-		Attribute* curAttr = m_firstAttr;
-
-		while (curAttr->next)
-		{
-			curAttr = curAttr->next;
-		}
-
-		//and add it at the end
-		curAttr->next = attr;
-	}
-	else
+	switch (type)
 	{
-		//is the first
-		m_firstAttr = attr;
+		case ATTR_ITEM_OWNER:
+			return EXTRA_ATTR_OWNER;
+		case ATTR_ITEM_DURATION:
+			return EXTRA_ATTR_DURATION;
+		case ATTR_ITEM_DECAYING:
+			return EXTRA_ATTR_DECAYING;
+		case ATTR_ITEM_WRITTENDATE:
+			return EXTRA_ATTR_WRITTENDATE;
+		case ATTR_ITEM_CORPSEOWNER:
+			return EXTRA_ATTR_CORPSEOWNER;
+		case ATTR_ITEM_FLUIDTYPE:
+			return EXTRA_ATTR_FLUIDTYPE;
+		case ATTR_ITEM_DOORID:
+			return EXTRA_ATTR_DOORID;
+		default:
+			return -1;
 	}
-
-	//add it to flags
-	m_attributes = m_attributes | attr->type;
 }
 
-ItemAttributes::Attribute* ItemAttributes::getAttrConst(const itemAttrTypes& type) const
+int32_t ItemAttributes::getStrAttrIndex(const itemAttrTypes& type)
 {
-	//check flags
-	if ((type & m_attributes) == 0)
+	switch (type)
 	{
-		return NULL;
+		case ATTR_ITEM_DESC:
+			return STR_ATTR_DESC;
+		case ATTR_ITEM_TEXT:
+			return STR_ATTR_TEXT;
+		case ATTR_ITEM_WRITTENBY:
+			return STR_ATTR_WRITTENBY;
+		default:
+			return -1;
 	}
+}
 
-	//it is here, so search it in the linked list
-	Attribute* curAttr = m_firstAttr;
-
-	while (curAttr)
+ItemAttributes::ExtraAttributes* ItemAttributes::getExtraAttrs()
+{
+	if (!m_extra)
 	{
-		if (curAttr->type == type)
+		m_extra = new ExtraAttributes();
+
+		for (int32_t n = 0; n < EXTRA_ATTR_LAST; ++n)
 		{
-			//found
-			return curAttr;
+			m_extra->values[n] = 0;
 		}
 
-		curAttr = curAttr->next;
+		m_extra->strings = NULL;
 	}
 
-	//not found?
-	std::cout << "Warning: [ItemAttributes::getAttrConst] (type & m_attributes) != 0 but attribute not found" << std::endl;
-	return NULL;
+	return m_extra;
 }
 
-ItemAttributes::Attribute* ItemAttributes::getAttr(const itemAttrTypes& type)
+void ItemAttributes::releaseExtraAttrs()
 {
-	Attribute* curAttr;
+	static const uint32_t inlineAttrs = ATTR_ITEM_ACTIONID | ATTR_ITEM_UNIQUEID | ATTR_ITEM_CHARGES;
 
-	if ((type & m_attributes) == 0)
+	//free the blocks once nothing in them is used anymore
+	if (m_extra && m_extra->strings && (m_attributes & (ATTR_ITEM_DESC | ATTR_ITEM_TEXT | ATTR_ITEM_WRITTENBY)) == 0)
 	{
-		//if that type was not present add it
-		curAttr = new Attribute(type);
-		addAttr(curAttr);
-		return curAttr;
+		delete[] m_extra->strings;
+		m_extra->strings = NULL;
 	}
-	else
-	{
-		//was present, search and return it
-		curAttr = m_firstAttr;
 
-		while (curAttr)
-		{
-			if (curAttr->type == type)
-			{
-				return curAttr;
-			}
-
-			curAttr = curAttr->next;
-		}
+	if (m_extra && (m_attributes & ~inlineAttrs) == 0)
+	{
+		deleteAttrs();
 	}
-
-	std::cout << "Warning: [ItemAttributes::getAttr] (type & m_attributes) != 0 but attribute not found" << std::endl;
-	curAttr = new Attribute(type);
-	addAttr(curAttr);
-	return curAttr;
 }
 
-void ItemAttributes::deleteAttrs(Attribute* attr)
+void ItemAttributes::deleteAttrs()
 {
-	//deletes all attributes recursively
-	if (attr)
+	if (m_extra)
 	{
-		//if is string type, delete the allocated string
-		if (validateStrAttrType(attr->type))
-		{
-			delete(std::string*)attr->value;
-		}
-
-		Attribute* next_attr = attr->next;
-		attr->next = NULL;
-
-		//delete next while it was not NULL
-		if (next_attr)
-		{
-			deleteAttrs(next_attr);
-		}
-
-		delete attr;
+		delete[] m_extra->strings;
+		delete m_extra;
+		m_extra = NULL;
 	}
 }
 
@@ -724,12 +687,7 @@ Item::Item(const Item& i)
 	//std::cout << "Item copy constructor " << this << std::endl;
 	id = i.id;
 	count = i.count;
-	m_attributes = i.m_attributes;
-
-	if (i.m_firstAttr)
-	{
-		m_firstAttr = new Attribute(*i.m_firstAttr);
-	}
+	ItemAttributes::operator=(i);
 }
 
 Item::~Item()
@@ -740,25 +698,13 @@ Item::~Item()
 Item* Item::clone() const
 {
 	Item* _item = Item::CreateItem(id, count);
-	_item->m_attributes = m_attributes;
-
-	if (m_firstAttr)
-	{
-		_item->m_firstAttr = new Attribute(*m_firstAttr);
-	}
-
+	_item->ItemAttributes::operator=(*this);
 	return _item;
 }
 
 void Item::copyAttributes(Item* item)
 {
-	m_attributes = item->m_attributes;
-
-	if (item->m_firstAttr)
-	{
-		m_firstAttr = new Attribute(*item->m_firstAttr);
-	}
-
+	ItemAttributes::operator=(*item);
 	removeAttribute(ATTR_ITEM_DECAYING);
 	removeAttribute(ATTR_ITEM_DURATION);
 }
@@ -1329,8 +1275,11 @@ int Item::getThrowRange() const
 
 bool Item::hasProperty(const ITEMPROPERTY& prop) const
 {
-	const ItemType& it = items[id];
+	return hasProperty(items[id], prop, getUniqueId() != 0);
+}
 
+bool Item::hasProperty(const ItemType& it, const ITEMPROPERTY& prop, bool hasUniqueId /*= false*/)
+{
 	switch (prop)
 	{
 		case BLOCKSOLID:
@@ -1343,7 +1292,7 @@ bool Item::hasProperty(const ITEMPROPERTY& prop) const
 			break;
 		case MOVEABLE:
 
-			if (it.moveable && getUniqueId() == 0)
+			if (it.moveable && !hasUniqueId)
 			{
 				return true;
 			}
@@ -1391,7 +1340,7 @@ bool Item::hasProperty(const ITEMPROPERTY& prop) const
 			break;
 		case IMMOVABLEBLOCKSOLID:
 
-			if (it.blockSolid && (!it.moveable || getUniqueId() != 0))
+			if (it.blockSolid && (!it.moveable || hasUniqueId))
 			{
 				return true;
 			}
@@ -1399,7 +1348,7 @@ bool Item::hasProperty(const ITEMPROPERTY& prop) const
 			break;
 		case IMMOVABLEBLOCKPATH:
 
-			if (it.blockPathFind && (!it.moveable || getUniqueId() != 0))
+			if (it.blockPathFind && (!it.moveable || hasUniqueId))
 			{
 				return true;
 			}
@@ -1415,7 +1364,7 @@ bool Item::hasProperty(const ITEMPROPERTY& prop) const
 			break;
 		case IMMOVABLENOFIELDBLOCKPATH:
 
-			if (!it.isMagicField() && it.blockPathFind && (!it.moveable || getUniqueId() != 0))
+			if (!it.isMagicField() && it.blockPathFind && (!it.moveable || hasUniqueId))
 			{
 				return true;
 			}
@@ -127,6 +127,13 @@ public:
 	ItemAttributes(const ItemAttributes& i);
 	virtual ~ItemAttributes();
 
+	ItemAttributes& operator=(const ItemAttributes& i);
+
+	bool hasAttributes() const
+	{
+		return m_attributes != 0;
+	}
+
 	void setSpecialDescription(const std::string& desc);
 	void resetSpecialDescription();
 	const std::string& getSpecialDescription() const;
@@ -144,16 +151,28 @@ public:
 	const std::string& getWriter() const;
 
 	void setActionId(const uint16_t& n);
-	uint16_t getActionId() const;
+	uint16_t getActionId() const
+	{
+		return m_actionId;
+	}
 
 	void setUniqueId(const uint16_t& n);
-	uint16_t getUniqueId() const;
+	uint16_t getUniqueId() const
+	{
+		return m_uniqueId;
+	}
 
 	void setCharges(const uint16_t& n);
-	uint16_t getCharges() const;
+	uint16_t getCharges() const
+	{
+		return m_charges;
+	}
 
 	void setFluidType(const uint16_t& n);
-	uint16_t getFluidType() const;
+	uint16_t getFluidType() const
+	{
+		return (uint16_t)getExtraAttr(EXTRA_ATTR_FLUIDTYPE);
+	}
 
 	void setOwner(const uint32_t& _owner);
 	uint32_t getOwner() const;
@@ -163,10 +182,16 @@ public:
 
 	void setDuration(const int32_t& time);
 	void decreaseDuration(const int32_t& time);
-	int32_t getDuration() const;
+	int32_t getDuration() const
+	{
+		return getExtraAttr(EXTRA_ATTR_DURATION);
+	}
 
 	void setDecaying(const ItemDecayState_t& decayState);
-	uint32_t getDecaying() const;
+	uint32_t getDecaying() const
+	{
+		return (uint32_t)getExtraAttr(EXTRA_ATTR_DECAYING);
+	}
 
 protected:
 	enum itemAttrTypes
@@ -190,43 +215,32 @@ protected:
 	void removeAttribute(const itemAttrTypes& type);
 
 protected:
-	class Attribute
+	// Slots of the integer attributes that are not kept inline
+	enum extraAttrIndex
 	{
-	public:
-		itemAttrTypes type;
-		void* value;
-		Attribute* next;
-		Attribute(itemAttrTypes _type)
-		{
-			type = _type;
-			value = NULL;
-			next = NULL;
-		}
-
-		Attribute(const Attribute& i)
-		{
-			type = i.type;
-
-			if (ItemAttributes::validateIntAttrType(type))
-			{
-				value = i.value;
-			}
-			else if (ItemAttributes::validateStrAttrType(type))
-			{
-				value = (void*)new std::string(*((std::string*)i.value));
-			}
-			else
-			{
-				value = NULL;
-			}
-
-			next = NULL;
-
-			if (i.next)
-			{
-				next = new Attribute(*i.next);
-			}
-		}
+		EXTRA_ATTR_OWNER,
+		EXTRA_ATTR_DURATION,
+		EXTRA_ATTR_DECAYING,
+		EXTRA_ATTR_WRITTENDATE,
+		EXTRA_ATTR_CORPSEOWNER,
+		EXTRA_ATTR_FLUIDTYPE,
+		EXTRA_ATTR_DOORID,
+		EXTRA_ATTR_LAST
+	};
+
+	enum strAttrIndex
+	{
+		STR_ATTR_DESC,
+		STR_ATTR_TEXT,
+		STR_ATTR_WRITTENBY,
+		STR_ATTR_LAST
+	};
+
+	// Allocated once the first of these attributes is set, unset values are 0
+	struct ExtraAttributes
+	{
+		int32_t values[EXTRA_ATTR_LAST];
+		std::string* strings;
 	};
 
 	const std::string& getStrAttr(const itemAttrTypes& type) const;
@@ -239,14 +253,24 @@ protected:
 	static bool validateIntAttrType(const itemAttrTypes& type);
 	static bool validateStrAttrType(const itemAttrTypes& type);
 
-	void addAttr(Attribute* attr);
-	Attribute* getAttrConst(const itemAttrTypes& type) const;
-	Attribute* getAttr(const itemAttrTypes& type);
+	static int32_t getExtraAttrIndex(const itemAttrTypes& type);
+	static int32_t getStrAttrIndex(const itemAttrTypes& type);
 
-	void deleteAttrs(Attribute* attr);
-
-	uint32_t m_attributes;
-	Attribute* m_firstAttr;
+	int32_t getExtraAttr(const extraAttrIndex& index) const
+	{
+		return m_extra ? m_extra->values[index] : 0;
+	}
+
+	ExtraAttributes* getExtraAttrs();
+	void releaseExtraAttrs();
+	void deleteAttrs();
+
+	uint16_t m_attributes;
+	// the common integer attributes are kept inline, unset values are 0
+	uint16_t m_actionId;
+	uint16_t m_uniqueId;
+	uint16_t m_charges;
+	ExtraAttributes* m_extra;
 };
 
 class Item : virtual public Thing, public ItemAttributes
@@ -332,6 +356,7 @@ public:
 	void getLight(LightInfo& lightInfo);
 
 	bool hasProperty(const ITEMPROPERTY& prop) const;
+	static bool hasProperty(const ItemType& it, const ITEMPROPERTY& prop, bool hasUniqueId = false);
 	bool isBlocking(const Creature* creature) const;
 	bool isStackable() const;
 	bool isRune() const;
@@ -4651,6 +4651,7 @@ int LuaScriptInterface::luaDoSetItemActionId(lua_State* L)
 		}
 
 		item->setActionId(actionid);
+		Player::setItemSaveDirty(item);
 		g_moveEvents->onAddTileItem(item->getTile(), item);
 		lua_pushboolean(L, true);
 	}
@@ -4675,6 +4676,7 @@ int LuaScriptInterface::luaDoSetItemText(lua_State* L)
 	{
 		std::string str(text);
 		item->setText(str);
+		Player::setItemSaveDirty(item);
 		lua_pushboolean(L, true);
 	}
 	else
@@ -4707,6 +4709,7 @@ int LuaScriptInterface::luaDoSetItemSpecialDescription(lua_State* L)
 			item->resetSpecialDescription();
 		}
 
+		Player::setItemSaveDirty(item);
 		lua_pushboolean(L, true);
 	}
 	else
@@ -9097,7 +9100,7 @@ int LuaScriptInterface::luaHasProperty(lua_State* L)
 	//Check if the item is a tile, so we can get more accurate properties
 	bool hasProp = item->hasProperty((ITEMPROPERTY)prop);
 
-	if (item->getTile() && item->getTile()->ground == item)
+	if (item->getTile() && item->getTile()->getGround() == item)
 	{
 		hasProp = item->getTile()->hasProperty((ITEMPROPERTY)prop);
 	}
@@ -31,6 +31,7 @@
 #include "configmanager.h"
 #include <boost/config.hpp>
 #include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
 #include <cstdio>
 #include <iomanip>
 #include <string>
@@ -44,6 +45,7 @@ Map::Map()
 {
 	mapWidth = 0;
 	mapHeight = 0;
+	pathCacheInserts = 0;
 }
 
 Map::~Map()
@@ -220,6 +222,11 @@ void Map::setTile(int32_t x, int32_t y, int32_t z, Tile* newtile)
 		std::cout << "Error: Map::setTile() already exists." << std::endl;
 	}
 
+	if (leaf->updateTileFlags(newtile))
+	{
+		clearSightCache();
+	}
+
 	if (newtile->hasFlag(TILESTATE_REFRESH))
 	{
 		RefreshBlock_t rb;
@@ -328,7 +335,7 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 		Cylinder* toCylinder = tile->__queryDestination(index, creature, &toItem, flags);
 		toCylinder->__internalAddThing(creature);
 		Tile* toTile = toCylinder->getTile();
-		toTile->qt_node->addCreature(creature);
+		toTile->qt_node->addCreature(creature, toTile->getPosition().z);
 		return true;
 	}
 
@@ -344,7 +351,7 @@ bool Map::removeCreature(Creature* creature)
 
 	if (tile)
 	{
-		tile->qt_node->removeCreature(creature);
+		tile->qt_node->removeCreature(creature, tile->getPosition().z);
 		tile->__removeThing(creature, 0);
 		return true;
 	}
@@ -355,7 +362,7 @@ bool Map::removeCreature(Creature* creature)
 void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, bool checkforduplicate,
                                 int32_t minRangeX, int32_t maxRangeX,
                                 int32_t minRangeY, int32_t maxRangeY,
-                                int32_t minRangeZ, int32_t maxRangeZ)
+                                int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers /*= false*/)
 {
 	int32_t minoffset = centerPos.z - maxRangeZ;
 	int32_t x1 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.x + minRangeX + minoffset)));
@@ -381,17 +388,30 @@ void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, b
 		{
 			if (leafE)
 			{
-				CreatureVector& node_list = leafE->creature_list;
-				CreatureVector::const_iterator node_iter = node_list.begin();
-				CreatureVector::const_iterator node_end = node_list.end();
-
-				if (node_iter != node_end)
+				// only the floors in range are scanned
+				for (int32_t nz = minRangeZ; nz <= maxRangeZ; ++nz)
 				{
+					Floor* floor = leafE->getFloor(nz);
+
+					if (!floor)
+					{
+						continue;
+					}
+
+					const CreatureVector& node_list = (onlyPlayers ? floor->players : floor->creatures);
+
+					if (node_list.empty())
+					{
+						continue;
+					}
+
+					int32_t offsetZ = centerPos.z - nz;
+					CreatureVector::const_iterator node_iter = node_list.begin();
+					CreatureVector::const_iterator node_end = node_list.end();
+
 					do
 					{
 						Creature* creature = *node_iter;
-						const Position& cpos = creature->getPosition();
-						int32_t offsetZ = centerPos.z - cpos.z;
 
 						//3lite - temporal "fix" TODO !!
 						if (!creature || creature->isRemoved())
@@ -401,10 +421,7 @@ void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, b
 							continue;
 						}
 
-						if (cpos.z < minRangeZ || cpos.z > maxRangeZ)
-						{
-							continue;
-						}
+						const Position& cpos = creature->getPosition();
 
 						if (cpos.y < (centerPos.y + minRangeY + offsetZ) || cpos.y > (centerPos.y + maxRangeY + offsetZ))
 						{
@@ -453,18 +470,19 @@ void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, b
 void Map::getSpectators(SpectatorVec& list, const Position& centerPos,
                         bool checkforduplicate /*= false*/, bool multifloor /*= false*/,
                         int32_t minRangeX /*= 0*/, int32_t maxRangeX /*= 0*/,
-                        int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/)
+                        int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/, bool onlyPlayers /*= false*/)
 {
 	if (centerPos.z < MAP_MAX_LAYERS)
 	{
 		bool foundCache = false;
 		bool cacheResult = false;
+		SpectatorCache& cache = (onlyPlayers ? playerSpectatorCache : spectatorCache);
 
 		if (minRangeX == 0 && maxRangeX == 0 && minRangeY == 0 && maxRangeY == 0 && multifloor && !checkforduplicate)
 		{
-			SpectatorCache::iterator it = spectatorCache.find(centerPos);
+			SpectatorCache::iterator it = cache.find(centerPos);
 
-			if (it != spectatorCache.end())
+			if (it != cache.end())
 			{
 				list = *it->second;
 				foundCache = true;
@@ -519,30 +537,31 @@ void Map::getSpectators(SpectatorVec& list, const Position& centerPos,
 			getSpectatorsInternal(list, centerPos, true,
 			                      minRangeX, maxRangeX,
 			                      minRangeY, maxRangeY,
-			                      minRangeZ, maxRangeZ);
+			                      minRangeZ, maxRangeZ, onlyPlayers);
 
 			if (cacheResult)
 			{
-				spectatorCache[centerPos].reset(new SpectatorVec(list));
+				cache[centerPos].reset(new SpectatorVec(list));
 			}
 		}
 	}
 }
 
-const SpectatorVec& Map::getSpectators(const Position& centerPos)
+const SpectatorVec& Map::getSpectators(const Position& centerPos, bool onlyPlayers /*= false*/)
 {
 	if (centerPos.z < MAP_MAX_LAYERS)
 	{
-		SpectatorCache::iterator it = spectatorCache.find(centerPos);
+		SpectatorCache& cache = (onlyPlayers ? playerSpectatorCache : spectatorCache);
+		SpectatorCache::iterator it = cache.find(centerPos);
 
-		if (it != spectatorCache.end())
+		if (it != cache.end())
 		{
 			return *it->second;
 		}
 		else
 		{
 			boost::shared_ptr<SpectatorVec> p(new SpectatorVec());
-			spectatorCache[centerPos] = p;
+			cache[centerPos] = p;
 			SpectatorVec& list = *p;
 			int32_t minRangeX = -maxViewportX;
 			int32_t maxRangeX = maxViewportX;
@@ -578,7 +597,7 @@ const SpectatorVec& Map::getSpectators(const Position& centerPos)
 			getSpectatorsInternal(list, centerPos, false,
 			                      minRangeX, maxRangeX,
 			                      minRangeY, maxRangeY,
-			                      minRangeZ, maxRangeZ);
+			                      minRangeZ, maxRangeZ, onlyPlayers);
 			return list;
 		}
 	}
@@ -593,6 +612,7 @@ const SpectatorVec& Map::getSpectators(const Position& centerPos)
 void Map::clearSpectatorCache()
 {
 	spectatorCache.clear();
+	playerSpectatorCache.clear();
 }
 
 bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool checkLineOfSight /*= true*/,
@@ -644,6 +664,10 @@ bool Map::checkSightLine(const Position& fromPos, const Position& toPos) const
 	int32_t A = destination.y - start.y;
 	int32_t B = start.x - destination.x;
 	int32_t C = -(A * destination.x + B * destination.y);
+	// the line crosses few leaves, so the leaf is only looked up again when leaving it
+	const QTreeLeafNode* leaf = NULL;
+	int32_t leafX = -1;
+	int32_t leafY = -1;
 
 	while (!Position::areInRange<0, 0, 15>(start, destination))
 	{
@@ -661,9 +685,16 @@ bool Map::checkSightLine(const Position& fromPos, const Position& toPos) const
 			start.x += mx;
 		}
 
-		const Tile* tile = const_cast<Map*>(this)->getTile(start.x, start.y, start.z);
+		if ((start.x & ~FLOOR_MASK) != leafX || (start.y & ~FLOOR_MASK) != leafY)
+		{
+			leafX = start.x & ~FLOOR_MASK;
+			leafY = start.y & ~FLOOR_MASK;
+			leaf = QTreeNode::getLeafStatic(const_cast<QTreeNode*>(&root), start.x, start.y);
+		}
+
+		const Floor* floor = (leaf ? const_cast<QTreeLeafNode*>(leaf)->getFloor(start.z) : NULL);
 
-		if (tile && tile->hasProperty(BLOCKPROJECTILE))
+		if (floor && (floor->blockProjectile & FLOOR_BIT(start.x, start.y)))
 		{
 			return false;
 		}
@@ -691,7 +722,44 @@ bool Map::isSightClear(const Position& fromPos, const Position& toPos, bool floo
 		return false;
 	}
 
-	return checkSightLine(fromPos, toPos) || checkSightLine(toPos, fromPos);
+	int32_t dx = toPos.x - fromPos.x;
+	int32_t dy = toPos.y - fromPos.y;
+
+	if (fromPos.z != toPos.z || std::abs(dx) > 127 || std::abs(dy) > 127)
+	{
+		return checkSightLine(fromPos, toPos) || checkSightLine(toPos, fromPos);
+	}
+
+	// on the same floor only the projectile bitmaps decide, both directions
+	// are checked so the pair shares one entry
+	const Position& pos = (toPos < fromPos ? toPos : fromPos);
+
+	if (&pos == &toPos)
+	{
+		dx = -dx;
+		dy = -dy;
+	}
+
+	uint64_t key = ((uint64_t)pos.x << 36) | ((uint64_t)pos.y << 20) | ((uint64_t)pos.z << 16) |
+	               ((uint64_t)(uint8_t)dx << 8) | (uint64_t)(uint8_t)dy;
+	SightCache::const_iterator it = sightCache.find(key);
+
+	if (it != sightCache.end())
+	{
+		return it->second;
+	}
+
+	bool clear = checkSightLine(fromPos, toPos) || checkSightLine(toPos, fromPos);
+	sightCache[key] = clear;
+	return clear;
+}
+
+void Map::clearSightCache()
+{
+	if (!sightCache.empty())
+	{
+		sightCache.clear();
+	}
 }
 
 const Tile* Map::canWalkTo(const Creature* creature, const Position& pos)
@@ -706,11 +774,48 @@ const Tile* Map::canWalkTo(const Creature* creature, const Position& pos)
 	}
 
 	//used for none-cached tiles
-	Tile* tile = getTile(pos);
+	QTreeLeafNode* leaf = QTreeNode::getLeafStatic(&root, pos.x, pos.y);
+	Floor* floor = (leaf ? leaf->getFloor(pos.z) : NULL);
+
+	if (!floor)
+	{
+		return NULL;
+	}
+
+	Tile* tile = floor->tiles[pos.x & FLOOR_MASK][pos.y & FLOOR_MASK];
 
 	if (creature->getTile() != tile)
 	{
-		if (!tile || tile->__queryAdd(0, creature, 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) != RET_NOERROR)
+		if (!tile)
+		{
+			return NULL;
+		}
+
+		// the bitmaps turn down what __queryAdd would always refuse, house
+		// tiles only let players in
+		uint64_t bit = FLOOR_BIT(pos.x, pos.y);
+
+		if ((floor->noPathing & bit) || (!creature->getPlayer() && (floor->house & bit)))
+		{
+			return NULL;
+		}
+
+		if (const Monster* monster = creature->getMonster())
+		{
+			uint64_t blocked = floor->protectionZone | floor->immovableBlockSolid;
+
+			if (!monster->canPushItems())
+			{
+				blocked |= floor->blockSolid;
+			}
+
+			if (blocked & bit)
+			{
+				return NULL;
+			}
+		}
+
+		if (tile->__queryAdd(0, creature, 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) != RET_NOERROR)
 		{
 			return NULL;
 		}
@@ -736,7 +841,8 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 		return false;
 	}
 
-	AStarNodes nodes;
+	AStarNodes& nodes = AStarNodes::getThreadNodes();
+	nodes.clear();
 	AStarNode* startNode = nodes.createOpenNode();
 	startNode->x = startPos.x;
 	startNode->y = startPos.y;
@@ -894,9 +1000,19 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
                           const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
 {
 	dirList.clear();
+
+	// monsters chasing the same target share their paths
+	bool usePathCache = (creature->getMonster() != NULL);
+
+	if (usePathCache && getCachedPath(creature, dirList, pathCondition, fpp))
+	{
+		return true;
+	}
+
 	Position startPos = creature->getPosition();
 	Position endPos;
-	AStarNodes nodes;
+	AStarNodes& nodes = AStarNodes::getThreadNodes();
+	nodes.clear();
 	AStarNode* startNode = nodes.createOpenNode();
 	startNode->x = startPos.x;
 	startNode->y = startPos.y;
@@ -1029,6 +1145,11 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 		return false;
 	}
 
+	if (usePathCache && bestMatch == 0)
+	{
+		cachePath(found, startPos.z, pathCondition, fpp);
+	}
+
 	found = found->parent;
 
 	while (found)
@@ -1079,12 +1200,267 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 	return true;
 }
 
+static Direction getStepDirection(const Position& fromPos, const Position& toPos)
+{
+	int32_t dx = toPos.x - fromPos.x;
+	int32_t dy = toPos.y - fromPos.y;
+
+	if (dx == -1 && dy == -1)
+	{
+		return NORTHWEST;
+	}
+	else if (dx == 1 && dy == -1)
+	{
+		return NORTHEAST;
+	}
+	else if (dx == -1 && dy == 1)
+	{
+		return SOUTHWEST;
+	}
+	else if (dx == 1 && dy == 1)
+	{
+		return SOUTHEAST;
+	}
+	else if (dx == -1)
+	{
+		return WEST;
+	}
+	else if (dx == 1)
+	{
+		return EAST;
+	}
+	else if (dy == -1)
+	{
+		return NORTH;
+	}
+
+	return SOUTH;
+}
+
+bool Map::PathCacheKey::operator<(const PathCacheKey& other) const
+{
+	if (!(targetPos == other.targetPos))
+	{
+		return targetPos < other.targetPos;
+	}
+
+	if (maxSearchDist != other.maxSearchDist)
+	{
+		return maxSearchDist < other.maxSearchDist;
+	}
+
+	if (minTargetDist != other.minTargetDist)
+	{
+		return minTargetDist < other.minTargetDist;
+	}
+
+	if (maxTargetDist != other.maxTargetDist)
+	{
+		return maxTargetDist < other.maxTargetDist;
+	}
+
+	return flags < other.flags;
+}
+
+Map::PathCacheKey Map::getPathCacheKey(const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
+{
+	PathCacheKey key;
+	key.targetPos = pathCondition.getTargetPos();
+	key.maxSearchDist = fpp.maxSearchDist;
+	key.minTargetDist = fpp.minTargetDist;
+	key.maxTargetDist = fpp.maxTargetDist;
+	key.flags = (fpp.fullPathSearch ? 1 : 0) | (fpp.clearSight ? 2 : 0) |
+	            (fpp.allowDiagonal ? 4 : 0) | (fpp.keepDistance ? 8 : 0);
+	return key;
+}
+
+bool Map::getCachedPath(const Creature* creature, std::list<Direction>& dirList,
+                        const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
+{
+	PathCache::iterator it = pathCache.find(getPathCacheKey(pathCondition, fpp));
+
+	if (it == pathCache.end())
+	{
+		return false;
+	}
+
+	if (it->second.expireTime < OTSYS_TIME())
+	{
+		pathCache.erase(it);
+		return false;
+	}
+
+	// follow the steps from our position, every step is checked again for
+	// this creature so tiles that got blocked since drop the cached path
+	const std::map<Position, Position>& steps = it->second.steps;
+	const Position startPos = creature->getPosition();
+	Position pos = startPos;
+
+	for (uint32_t i = 0; i < MAX_NODES; ++i)
+	{
+		std::map<Position, Position>::const_iterator step = steps.find(pos);
+
+		if (step == steps.end())
+		{
+			break;
+		}
+
+		const Position& nextPos = step->second;
+
+		if (nextPos == pos)
+		{
+			int32_t bestMatch = 0;
+
+			if (pathCondition(startPos, pos, fpp, bestMatch) && bestMatch == 0)
+			{
+				return true;
+			}
+
+			break;
+		}
+
+		if (fpp.maxSearchDist != -1 && (std::abs(startPos.x - nextPos.x) > fpp.maxSearchDist ||
+		                                std::abs(startPos.y - nextPos.y) > fpp.maxSearchDist))
+		{
+			break;
+		}
+
+		if (fpp.keepDistance && !pathCondition.isInRange(startPos, nextPos, fpp))
+		{
+			break;
+		}
+
+		if (!canWalkTo(creature, nextPos))
+		{
+			break;
+		}
+
+		dirList.push_back(getStepDirection(pos, nextPos));
+		pos = nextPos;
+	}
+
+	dirList.clear();
+	return false;
+}
+
+void Map::cachePath(const AStarNode* endNode, int32_t z,
+                    const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
+{
+	int64_t now = OTSYS_TIME();
+
+	// expired entries are dropped when looked up, the sweep only catches
+	// the ones nobody asks for again
+	if (++pathCacheInserts >= MAP_PATHCACHE_SWEEP)
+	{
+		pathCacheInserts = 0;
+
+		for (PathCache::iterator it = pathCache.begin(); it != pathCache.end();)
+		{
+			if (it->second.expireTime < now)
+			{
+				pathCache.erase(it++);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	PathCacheEntry& entry = pathCache[getPathCacheKey(pathCondition, fpp)];
+
+	if (entry.steps.empty() || entry.expireTime < now)
+	{
+		entry.steps.clear();
+		entry.expireTime = now + MAP_PATHCACHE_TIME;
+	}
+
+	Position pos(endNode->x, endNode->y, z);
+	entry.steps[pos] = pos;
+
+	for (const AStarNode* node = endNode; node->parent; node = node->parent)
+	{
+		entry.steps[Position(node->parent->x, node->parent->y, z)] = Position(node->x, node->y, z);
+	}
+}
+
 //*********** AStarNodes *************
 
 AStarNodes::AStarNodes()
+{
+	tableStamp = 0;
+
+	for (uint32_t i = 0; i < NODE_TABLE_SIZE; ++i)
+	{
+		tableStamps[i] = 0;
+	}
+
+	openHeap.reserve(MAX_NODES * 2);
+	pendingNodes.reserve(MAX_NODES);
+	clear();
+}
+
+AStarNodes& AStarNodes::getThreadNodes()
+{
+	static boost::thread_specific_ptr<AStarNodes> threadNodes;
+
+	if (!threadNodes.get())
+	{
+		threadNodes.reset(new AStarNodes());
+	}
+
+	return *threadNodes;
+}
+
+void AStarNodes::clear()
 {
 	curNode = 0;
+	closedNodes = 0;
+	indexedNodes = 0;
 	openNodes.reset();
+	openHeap.clear();
+	pendingNodes.clear();
+
+	if (++tableStamp == 0)
+	{
+		// the stamp wrapped around, old entries could look valid again
+		for (uint32_t i = 0; i < NODE_TABLE_SIZE; ++i)
+		{
+			tableStamps[i] = 0;
+		}
+
+		tableStamp = 1;
+	}
+}
+
+static inline uint32_t getNodeTableIndex(int32_t x, int32_t y)
+{
+	return (uint32_t)(x * 31 + y * 65521) & (NODE_TABLE_SIZE - 1);
+}
+
+void AStarNodes::updateNodes()
+{
+	for (; indexedNodes < curNode; ++indexedNodes)
+	{
+		uint32_t i = getNodeTableIndex(nodes[indexedNodes].x, nodes[indexedNodes].y);
+
+		while (tableStamps[i] == tableStamp)
+		{
+			i = (i + 1) & (NODE_TABLE_SIZE - 1);
+		}
+
+		tableStamps[i] = tableStamp;
+		tableNodes[i] = indexedNodes;
+	}
+
+	for (std::vector<uint32_t>::iterator it = pendingNodes.begin(); it != pendingNodes.end(); ++it)
+	{
+		// std::greater turns the heap into a min heap, ties go to the oldest node
+		openHeap.push_back(OpenEntry(nodes[*it].f, *it));
+		std::push_heap(openHeap.begin(), openHeap.end(), std::greater<OpenEntry>());
+	}
+
+	pendingNodes.clear();
 }
 
 AStarNode* AStarNodes::createOpenNode()
@@ -1097,33 +1473,25 @@ AStarNode* AStarNodes::createOpenNode()
 	uint32_t ret_node = curNode;
 	curNode++;
 	openNodes[ret_node] = 1;
+	pendingNodes.push_back(ret_node);
 	return &nodes[ret_node];
 }
 
 AStarNode* AStarNodes::getBestNode()
 {
-	if (curNode == 0)
-	{
-		return NULL;
-	}
+	updateNodes();
 
-	int best_node_f = 100000;
-	uint32_t best_node = 0;
-	bool found = false;
-
-	for (uint32_t i = 0; i < curNode; ++i)
+	while (!openHeap.empty())
 	{
-		if (nodes[i].f < best_node_f && openNodes[i] == 1)
+		const OpenEntry& entry = openHeap.front();
+
+		if (openNodes[entry.second] == 1 && nodes[entry.second].f == entry.first)
 		{
-			found = true;
-			best_node_f = nodes[i].f;
-			best_node = i;
+			return &nodes[entry.second];
 		}
-	}
 
-	if (found)
-	{
-		return &nodes[best_node];
+		std::pop_heap(openHeap.begin(), openHeap.end(), std::greater<OpenEntry>());
+		openHeap.pop_back();
 	}
 
 	return NULL;
@@ -1140,7 +1508,11 @@ void AStarNodes::closeNode(AStarNode* node)
 		return;
 	}
 
-	openNodes[pos] = 0;
+	if (openNodes[pos] == 1)
+	{
+		openNodes[pos] = 0;
+		++closedNodes;
+	}
 }
 
 void AStarNodes::openNode(AStarNode* node)
@@ -1154,60 +1526,45 @@ void AStarNodes::openNode(AStarNode* node)
 		return;
 	}
 
-	openNodes[pos] = 1;
+	if (openNodes[pos] == 0)
+	{
+		openNodes[pos] = 1;
+		--closedNodes;
+	}
+
+	pendingNodes.push_back(pos);
 }
 
 uint32_t AStarNodes::countClosedNodes()
 {
-	uint32_t counter = 0;
-
-	for (uint32_t i = 0; i < curNode; ++i)
-	{
-		if (openNodes[i] == 0)
-		{
-			counter++;
-		}
-	}
-
-	return counter;
+	return closedNodes;
 }
 
 uint32_t AStarNodes::countOpenNodes()
 {
-	uint32_t counter = 0;
-
-	for (uint32_t i = 0; i < curNode; ++i)
-	{
-		if (openNodes[i] == 1)
-		{
-			counter++;
-		}
-	}
-
-	return counter;
+	return curNode - closedNodes;
 }
 
 bool AStarNodes::isInList(int32_t x, int32_t y)
 {
-	for (uint32_t i = 0; i < curNode; ++i)
-	{
-		if (nodes[i].x == x && nodes[i].y == y)
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return getNodeInList(x, y) != NULL;
 }
 
 AStarNode* AStarNodes::getNodeInList(int32_t x, int32_t y)
 {
-	for (uint32_t i = 0; i < curNode; ++i)
+	updateNodes();
+	uint32_t i = getNodeTableIndex(x, y);
+
+	while (tableStamps[i] == tableStamp)
 	{
-		if (nodes[i].x == x && nodes[i].y == y)
+		AStarNode* node = &nodes[tableNodes[i]];
+
+		if (node->x == x && node->y == y)
 		{
-			return &nodes[i];
+			return node;
 		}
+
+		i = (i + 1) & (NODE_TABLE_SIZE - 1);
 	}
 
 	return NULL;
@@ -1271,6 +1628,14 @@ Floor::Floor()
 			tiles[i][j] = 0;
 		}
 	}
+
+	blockProjectile = 0;
+	blockSolid = 0;
+	immovableBlockSolid = 0;
+	noPathing = 0;
+	protectionZone = 0;
+	house = 0;
+	version = 0;
 }
 
 //**************** QTreeNode **********************
@@ -1413,4 +1778,55 @@ Floor* QTreeLeafNode::createFloor(uint32_t z)
 	}
 
 	return m_array[z];
-}
\ No newline at end of file
+}
+
+void QTreeLeafNode::addCreature(Creature* c, uint16_t z)
+{
+	assert(c != NULL && m_array[z] != NULL);
+	m_array[z]->creatures.push_back(c);
+
+	if (c->getPlayer())
+	{
+		m_array[z]->players.push_back(c);
+	}
+}
+
+void QTreeLeafNode::removeCreature(Creature* c, uint16_t z)
+{
+	CreatureVector& creature_list = m_array[z]->creatures;
+	CreatureVector::iterator iter = std::find(creature_list.begin(), creature_list.end(), c);
+	assert(iter != creature_list.end());
+	std::swap(*iter, creature_list.back());
+	creature_list.pop_back();
+
+	if (c->getPlayer())
+	{
+		CreatureVector& player_list = m_array[z]->players;
+		iter = std::find(player_list.begin(), player_list.end(), c);
+		assert(iter != player_list.end());
+		std::swap(*iter, player_list.back());
+		player_list.pop_back();
+	}
+}
+
+bool QTreeLeafNode::updateTileFlags(const Tile* tile)
+{
+	const Position& pos = tile->getPosition();
+	Floor* floor = m_array[pos.z];
+
+	if (!floor || floor->tiles[pos.x & FLOOR_MASK][pos.y & FLOOR_MASK] != tile)
+	{
+		return false;
+	}
+
+	++floor->version;
+	uint64_t bit = FLOOR_BIT(pos.x, pos.y);
+	uint64_t blockProjectile = floor->blockProjectile;
+	setFloorBit(floor->blockProjectile, bit, tile->hasFlag(TILESTATE_BLOCKPROJECTILE));
+	setFloorBit(floor->blockSolid, bit, tile->hasFlag(TILESTATE_BLOCKSOLID));
+	setFloorBit(floor->immovableBlockSolid, bit, tile->hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID));
+	setFloorBit(floor->noPathing, bit, !tile->hasGround() || tile->floorChange() || tile->positionChange());
+	setFloorBit(floor->protectionZone, bit, tile->hasFlag(TILESTATE_PROTECTIONZONE));
+	setFloorBit(floor->house, bit, tile->hasFlag(TILESTATE_HOUSE));
+	return floor->blockProjectile != blockProjectile;
+}
@@ -56,16 +56,27 @@ struct AStarNode
 
 #define MAX_NODES 512
 #define GET_NODE_INDEX(a) (a - &nodes[0])
+// size of the position lookup table of AStarNodes, a power of two above MAX_NODES
+#define NODE_TABLE_SIZE (MAX_NODES * 2)
 
 #define MAP_NORMALWALKCOST 10
 #define MAP_DIAGONALWALKCOST 25
 
+// how long paths found for monsters are shared with others chasing the same target (ms)
+#define MAP_PATHCACHE_TIME 1000
+// paths cached between two sweeps for expired entries
+#define MAP_PATHCACHE_SWEEP 256
+
 class AStarNodes
 {
 public:
 	AStarNodes();
 	~AStarNodes() {};
 
+	// the nodes of the calling thread, reused by every search
+	static AStarNodes& getThreadNodes();
+	void clear();
+
 	AStarNode* createOpenNode();
 	AStarNode* getBestNode();
 	void closeNode(AStarNode* node);
@@ -81,9 +92,25 @@ public:
 	int32_t getEstimatedDistance(int32_t x, int32_t y, int32_t xGoal, int32_t yGoal);
 
 private:
+	// nodes only get their position after they are created and
+	// their cost after they are opened, so indexing them is deferred
+	void updateNodes();
+
 	AStarNode nodes[MAX_NODES];
 	std::bitset<MAX_NODES> openNodes;
 	uint32_t curNode;
+	uint32_t closedNodes;
+
+	// open nodes by f, entries of closed or cheaper reopened nodes are skipped
+	typedef std::pair<int32_t, uint32_t> OpenEntry;
+	std::vector<OpenEntry> openHeap;
+	std::vector<uint32_t> pendingNodes;
+
+	// nodes by position, entries of older searches have another stamp
+	uint32_t indexedNodes;
+	uint32_t tableStamp;
+	uint32_t tableStamps[NODE_TABLE_SIZE];
+	uint16_t tableNodes[NODE_TABLE_SIZE];
 };
 
 template<class T> class lessPointer : public std::binary_function<T*, T*, bool>
@@ -98,11 +125,27 @@ public:
 #define FLOOR_BITS 3
 #define FLOOR_SIZE (1 << FLOOR_BITS)
 #define FLOOR_MASK (FLOOR_SIZE - 1)
+#define FLOOR_BIT(x, y) ((uint64_t)1 << ((((y) & FLOOR_MASK) << FLOOR_BITS) | ((x) & FLOOR_MASK)))
 
 struct Floor
 {
 	Floor();
 	Tile* tiles[FLOOR_SIZE][FLOOR_SIZE];
+	// creatures standing on this floor of the leaf
+	CreatureVector creatures;
+	// the players among them, for broadcasts that only reach clients
+	CreatureVector players;
+	// state of the tiles that only changes with their items, one bit per
+	// tile (see FLOOR_BIT), so walk and sight checks can skip the item stacks
+	uint64_t blockProjectile;
+	uint64_t blockSolid;
+	uint64_t immovableBlockSolid;
+	// no ground, floor change or teleport, never entered while pathfinding
+	uint64_t noPathing;
+	uint64_t protectionZone;
+	uint64_t house;
+	// bumped whenever the items of one of the tiles change
+	uint32_t version;
 };
 
 class FrozenPathingConditionCall;
@@ -151,15 +194,28 @@ public:
 		return m_leafE;
 	}
 
-	void addCreature(Creature* c);
-	void removeCreature(Creature* c);
+	void addCreature(Creature* c, uint16_t z);
+	void removeCreature(Creature* c, uint16_t z);
+	// returns true if line of sight through the tile changed
+	bool updateTileFlags(const Tile* tile);
 
 protected:
+	static void setFloorBit(uint64_t& bits, const uint64_t& bit, bool value)
+	{
+		if (value)
+		{
+			bits |= bit;
+		}
+		else
+		{
+			bits &= ~bit;
+		}
+	}
+
 	static bool newLeaf;
 	QTreeLeafNode* m_leafS;
 	QTreeLeafNode* m_leafE;
 	Floor* m_array[MAP_MAX_LAYERS];
-	CreatureVector creature_list;
 
 	friend class Map;
 	friend class QTreeNode;
@@ -283,26 +339,63 @@ protected:
 	std::string spawnfile;
 	std::string housefile;
 	SpectatorCache spectatorCache;
+	SpectatorCache playerSpectatorCache;
 
 	// Actually scans the map for spectators
 	void getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, bool checkforduplicate,
 	                           int32_t minRangeX, int32_t maxRangeX,
 	                           int32_t minRangeY, int32_t maxRangeY,
-	                           int32_t minRangeZ, int32_t maxRangeZ);
+	                           int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers = false);
 
 	// Use this when a custom spectator vector is needed, this support many
 	// more parameters than the heavily cached version below.
 	void getSpectators(SpectatorVec& list, const Position& centerPos,
 	                   bool checkforduplicate = false, bool multifloor = false,
 	                   int32_t minRangeX = 0, int32_t maxRangeX = 0,
-	                   int32_t minRangeY = 0, int32_t maxRangeY = 0);
+	                   int32_t minRangeY = 0, int32_t maxRangeY = 0, bool onlyPlayers = false);
 	// The returned SpectatorVec is a temporary and should not be kept around
 	// Take special heed in that the vector will be destroyed if any function
 	// that calls clearSpectatorCache is called.
-	const SpectatorVec& getSpectators(const Position& centerPos);
+	const SpectatorVec& getSpectators(const Position& centerPos, bool onlyPlayers = false);
 
 	void clearSpectatorCache();
 
+	// Results of same floor line of sight checks, cleared after every task
+	// and whenever a tile starts or stops blocking projectiles
+	typedef std::unordered_map<uint64_t, bool> SightCache;
+	mutable SightCache sightCache;
+
+	void clearSightCache();
+
+	// Paths towards a target position found with the same search parameters,
+	// every position on them points to the next one and the goal to itself
+	struct PathCacheKey
+	{
+		Position targetPos;
+		int32_t maxSearchDist;
+		int32_t minTargetDist;
+		int32_t maxTargetDist;
+		uint8_t flags;
+
+		bool operator<(const PathCacheKey& other) const;
+	};
+
+	struct PathCacheEntry
+	{
+		int64_t expireTime;
+		std::map<Position, Position> steps;
+	};
+
+	typedef std::map<PathCacheKey, PathCacheEntry> PathCache;
+	PathCache pathCache;
+	uint32_t pathCacheInserts;
+
+	static PathCacheKey getPathCacheKey(const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp);
+	bool getCachedPath(const Creature* creature, std::list<Direction>& dirList,
+	                   const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp);
+	void cachePath(const AStarNode* endNode, int32_t z,
+	               const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp);
+
 	// Root node of the quad tree
 	QTreeNode root;
 
@@ -322,18 +415,4 @@ protected:
 	friend class IOMapSerialize;
 };
 
-inline void QTreeLeafNode::addCreature(Creature* c)
-{
-	assert(c != NULL);
-	creature_list.push_back(c);
-}
-
-inline void QTreeLeafNode::removeCreature(Creature* c)
-{
-	CreatureVector::iterator iter = std::find(creature_list.begin(), creature_list.end(), c);
-	assert(iter != creature_list.end());
-	std::swap(*iter, creature_list.back());
-	creature_list.pop_back();
-}
-
 #endif
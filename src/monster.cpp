@@ -779,6 +779,13 @@ void Monster::setIdle(bool _idle)
 		return;
 	}
 
+	if (_idle && isIdle)
+	{
+		// already out of the creature checks, updateIdleStatus runs for
+		// every creature moving by so this has to stay cheap
+		return;
+	}
+
 	isIdle = _idle;
 
 	if (!isIdle)
@@ -31,12 +31,21 @@
 
 NetworkMessage::NetworkMessage()
 {
+	m_MsgBuf = new uint8_t[NETWORKMESSAGE_MAXSIZE];
+	m_MsgCapacity = NETWORKMESSAGE_MAXSIZE;
+	Reset();
+}
+
+NetworkMessage::NetworkMessage(uint8_t* buffer, const int32_t& capacity)
+{
+	m_MsgBuf = buffer;
+	m_MsgCapacity = capacity;
 	Reset();
 }
 
 NetworkMessage::~NetworkMessage()
 {
-	// Virtual Destructor
+	delete[] m_MsgBuf;
 }
 
 uint8_t NetworkMessage::GetByte()
@@ -121,7 +130,7 @@ std::string NetworkMessage::GetString()
 {
 	uint16_t stringlen = GetU16();
 
-	if (stringlen >= (NETWORKMESSAGE_MAXSIZE - m_ReadPos))
+	if (stringlen >= (m_MsgCapacity - m_ReadPos))
 	{
 		return std::string();
 	}
@@ -135,7 +144,7 @@ std::string NetworkMessage::GetRaw()
 {
 	uint16_t stringlen = m_MsgSize - m_ReadPos;
 
-	if (stringlen >= (NETWORKMESSAGE_MAXSIZE - m_ReadPos))
+	if (stringlen >= (m_MsgCapacity - m_ReadPos))
 	{
 		return std::string();
 	}
@@ -345,7 +354,20 @@ void NetworkMessage::Reset()
 	m_ReadPos = 8;
 }
 
-bool NetworkMessage::canAdd(const uint32_t& size) const
+bool NetworkMessage::canAdd(const uint32_t& size)
+{
+	if (size + m_ReadPos >= max_body_length)
+	{
+		return false;
+	}
+
+	// keep room for the padding XTEA appends
+	uint32_t needed = size + m_ReadPos + xtea_multiple;
+	return needed <= (uint32_t)m_MsgCapacity || growBuffer(needed);
+}
+
+bool NetworkMessage::growBuffer(const uint32_t&)
 {
-	return (size + m_ReadPos < max_body_length);
+	// the own buffer always has the maximum size
+	return false;
 }
@@ -95,13 +95,23 @@ public:
 
 
 protected:
+	// takes ownership of a buffer smaller than NETWORKMESSAGE_MAXSIZE,
+	// growBuffer has to replace it before it overflows
+	NetworkMessage(uint8_t* buffer, const int32_t& capacity);
+
 	void Reset();
-	bool canAdd(const uint32_t& size) const;
+	bool canAdd(const uint32_t& size);
+	virtual bool growBuffer(const uint32_t& size);
 
 	int32_t m_MsgSize;
 	int32_t m_ReadPos;
 
-	uint8_t m_MsgBuf[NETWORKMESSAGE_MAXSIZE];
+	uint8_t* m_MsgBuf;
+	int32_t m_MsgCapacity;
+
+private:
+	NetworkMessage(const NetworkMessage&);
+	NetworkMessage& operator=(const NetworkMessage&);
 };
 
 typedef boost::shared_ptr<NetworkMessage> NetworkMessage_ptr;
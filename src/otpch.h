@@ -23,7 +23,6 @@
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/tokenizer.hpp>
-#include <boost/regex.hpp>
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 //std
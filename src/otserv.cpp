@@ -523,6 +523,7 @@ void mainLoader(const CommandLineOptions& command_opts, ServiceManager* service_
 	}
 
 	std::cout << "[done]" << std::endl;
+	IOPlayer::instance()->startSaveThread();
 	std::cout << ":: Checking Schema version... ";
 	DBResult* result;
 
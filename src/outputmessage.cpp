@@ -29,7 +29,15 @@ extern Dispatcher g_dispatcher;
 uint32_t OutputMessagePool::OutputMessagePoolCount = OUTPUT_POOL_SIZE;
 #endif
 
+static const int32_t outputBufferSizes[OUTPUT_BUFFER_CLASSES] =
+{
+	OUTPUT_BUFFER_SIZE_SMALL,
+	OUTPUT_BUFFER_SIZE_MEDIUM,
+	NETWORKMESSAGE_MAXSIZE
+};
+
 OutputMessage::OutputMessage()
+	: NetworkMessage(new uint8_t[OUTPUT_BUFFER_SIZE_SMALL], OUTPUT_BUFFER_SIZE_SMALL)
 {
 	freeMessage();
 }
@@ -79,10 +87,39 @@ void OutputMessage::freeMessage()
 	//4 bytes for checksum
 	//2 bytes for encrypted message size
 	m_outputBufferStart = 8;
+
+	//idle messages only keep a small buffer
+	if (m_MsgCapacity > OUTPUT_BUFFER_SIZE_SMALL)
+	{
+		OutputMessagePool* outputPool = OutputMessagePool::getInstance();
+		outputPool->releaseBuffer(m_MsgBuf, m_MsgCapacity);
+		m_MsgBuf = outputPool->getBuffer(0, m_MsgCapacity);
+	}
+
 	//setState have to be the last one
 	setState(OutputMessage::STATE_FREE);
 }
 
+bool OutputMessage::growBuffer(const uint32_t& size)
+{
+	int32_t capacity;
+	OutputMessagePool* outputPool = OutputMessagePool::getInstance();
+	uint8_t* buffer = outputPool->getBuffer(size, capacity);
+
+	if (!buffer)
+	{
+		return false;
+	}
+
+	//headers are only added once the body is complete, so the used part
+	//of the buffer ends at the write position
+	memcpy(buffer, m_MsgBuf, m_ReadPos);
+	outputPool->releaseBuffer(m_MsgBuf, m_MsgCapacity);
+	m_MsgBuf = buffer;
+	m_MsgCapacity = capacity;
+	return true;
+}
+
 void OutputMessage::setProtocol(Protocol* protocol)
 {
 	m_protocol = protocol;
@@ -126,12 +163,18 @@ OutputMessagePool::OutputMessagePool()
 
 OutputMessagePool::~OutputMessagePool()
 {
-	InternalOutputMessageList::iterator it;
-
-	for (it = m_outputMessages.begin(); it != m_outputMessages.end(); ++it)
+	for (InternalOutputMessageList::iterator it = m_outputMessages.begin(); it != m_outputMessages.end(); ++it)
 	{
 		delete *it;
 	}
+
+	for (uint32_t i = 0; i < OUTPUT_BUFFER_CLASSES; ++i)
+	{
+		for (std::vector<uint8_t*>::iterator it = m_freeBuffers[i].begin(); it != m_freeBuffers[i].end(); ++it)
+		{
+			delete[] *it;
+		}
+	}
 }
 
 OutputMessagePool* OutputMessagePool::getInstance()
@@ -179,26 +222,9 @@ void OutputMessagePool::send(OutputMessage_ptr msg)
 void OutputMessagePool::sendAll()
 {
 	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
-	OutputMessageMessageList::iterator it;
+	OutputMessageMessageList::iterator kept = m_autoSendOutputMessages.begin();
 
-	for (it = m_toAddQueue.begin(); it != m_toAddQueue.end();)
-	{
-		//drop messages that are older than 10 seconds
-		if (OTSYS_TIME() - (*it)->getFrame() > 10 * 1000)
-		{
-			(*it)->getProtocol()->onSendMessage(*it);
-			it = m_toAddQueue.erase(it);
-			continue;
-		}
-
-		(*it)->setState(OutputMessage::STATE_ALLOCATED);
-		m_autoSendOutputMessages.push_back(*it);
-		++it;
-	}
-
-	m_toAddQueue.clear();
-
-	for (it = m_autoSendOutputMessages.begin(); it != m_autoSendOutputMessages.end();)
+	for (OutputMessageMessageList::iterator it = m_autoSendOutputMessages.begin(); it != m_autoSendOutputMessages.end(); ++it)
 	{
 		OutputMessage_ptr omsg = *it;
 #ifdef __NO_PLAYER_SENDBUFFER__
@@ -209,35 +235,47 @@ void OutputMessagePool::sendAll()
 		bool v = omsg->getMessageLength() > 1024 || (m_frameTime - omsg->getFrame() > 10);
 #endif
 
-		if (v)
+		if (!v)
 		{
+			*kept++ = omsg;
+			continue;
+		}
+
 #ifdef __DEBUG_NET_DETAIL__
-			std::cout << "Sending message - ALL" << std::endl;
+		std::cout << "Sending message - ALL" << std::endl;
 #endif
+		Connection_ptr connection = omsg->getConnection();
 
-			if (omsg->getConnection())
+		if (connection)
+		{
+			// queue only, every connection writes its messages of this frame at once below
+			if (connection->send(omsg, false))
 			{
-				if (!omsg->getConnection()->send(omsg))
-				{
-					// Send only fails when connection is closing (or in error state)
-					// This call will free the message
-					omsg->getProtocol()->onSendMessage(omsg);
-				}
+				m_sendConnections.push_back(connection);
 			}
 			else
 			{
-#ifdef __DEBUG_NET__
-				std::cout << "Error: [OutputMessagePool::send] NULL connection." << std::endl;
-#endif
+				// Send only fails when connection is closing (or in error state)
+				// This call will free the message
+				omsg->getProtocol()->onSendMessage(omsg);
 			}
-
-			it = m_autoSendOutputMessages.erase(it);
 		}
 		else
 		{
-			++it;
+#ifdef __DEBUG_NET__
+			std::cout << "Error: [OutputMessagePool::send] NULL connection." << std::endl;
+#endif
 		}
 	}
+
+	m_autoSendOutputMessages.erase(kept, m_autoSendOutputMessages.end());
+
+	for (std::vector<Connection_ptr>::iterator it = m_sendConnections.begin(); it != m_sendConnections.end(); ++it)
+	{
+		(*it)->flushOutput();
+	}
+
+	m_sendConnections.clear();
 }
 
 void OutputMessagePool::stop()
@@ -324,6 +362,51 @@ OutputMessage_ptr OutputMessagePool::getOutputMessage(Protocol* protocol, bool a
 	return outputmessage;
 }
 
+uint8_t* OutputMessagePool::getBuffer(const uint32_t& size, int32_t& capacity)
+{
+	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
+
+	for (uint32_t i = 0; i < OUTPUT_BUFFER_CLASSES; ++i)
+	{
+		if (size <= (uint32_t)outputBufferSizes[i])
+		{
+			capacity = outputBufferSizes[i];
+
+			if (m_freeBuffers[i].empty())
+			{
+				return new uint8_t[capacity];
+			}
+
+			uint8_t* buffer = m_freeBuffers[i].back();
+			m_freeBuffers[i].pop_back();
+			return buffer;
+		}
+	}
+
+	return NULL;
+}
+
+void OutputMessagePool::releaseBuffer(uint8_t* buffer, const int32_t& capacity)
+{
+	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
+
+	for (uint32_t i = 0; i < OUTPUT_BUFFER_CLASSES; ++i)
+	{
+		if (capacity == outputBufferSizes[i])
+		{
+			if (m_freeBuffers[i].size() < OUTPUT_BUFFER_POOL_SIZE)
+			{
+				m_freeBuffers[i].push_back(buffer);
+				return;
+			}
+
+			break;
+		}
+	}
+
+	delete[] buffer;
+}
+
 void OutputMessagePool::startExecutionFrame()
 {
 	m_frameTime = OTSYS_TIME();
@@ -369,10 +452,3 @@ void OutputMessagePool::configureOutputMessage(OutputMessage_ptr msg, Protocol*
 #endif
 	msg->setFrame(m_frameTime);
 }
-
-void OutputMessagePool::addToAutoSend(OutputMessage_ptr msg)
-{
-	m_outputPoolLock.lock();
-	m_toAddQueue.push_back(msg);
-	m_outputPoolLock.unlock();
-}
@@ -30,6 +30,7 @@
 #include <boost/bind.hpp>
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include <boost/utility.hpp>
 
@@ -37,6 +38,14 @@ class Protocol;
 
 #define OUTPUT_POOL_SIZE 100
 
+// message buffers come in these sizes, a message starts with the smallest
+// one and moves to the next when it fills up
+#define OUTPUT_BUFFER_CLASSES 3
+#define OUTPUT_BUFFER_SIZE_SMALL 256
+#define OUTPUT_BUFFER_SIZE_MEDIUM 2048
+// free buffers kept per size class, the rest is deleted
+#define OUTPUT_BUFFER_POOL_SIZE 1000
+
 class OutputMessage : public NetworkMessage, boost::noncopyable
 {
 private:
@@ -48,8 +57,7 @@ public:
 	{
 		STATE_FREE,
 		STATE_ALLOCATED,
-		STATE_ALLOCATED_NO_AUTOSEND,
-		STATE_WAITING
+		STATE_ALLOCATED_NO_AUTOSEND
 	};
 
 	char* getOutputBuffer();
@@ -113,6 +121,7 @@ protected:
 
 
 	void freeMessage();
+	virtual bool growBuffer(const uint32_t& size);
 
 	friend class OutputMessagePool;
 
@@ -166,7 +175,9 @@ public:
 #endif
 	size_t getAvailableMessageCount() const;
 	size_t getAutoMessageCount() const;
-	void addToAutoSend(OutputMessage_ptr msg);
+
+	uint8_t* getBuffer(const uint32_t& size, int32_t& capacity);
+	void releaseBuffer(uint8_t* buffer, const int32_t& capacity);
 
 protected:
 
@@ -174,13 +185,15 @@ protected:
 	void releaseMessage(OutputMessage* msg);
 	void internalReleaseMessage(OutputMessage* msg);
 
-	typedef std::list<OutputMessage*> InternalOutputMessageList;
-	typedef std::list<OutputMessage_ptr> OutputMessageMessageList;
+	typedef std::vector<OutputMessage*> InternalOutputMessageList;
+	typedef std::vector<OutputMessage_ptr> OutputMessageMessageList;
 
 	InternalOutputMessageList m_outputMessages;
 	InternalOutputMessageList m_allOutputMessages;
 	OutputMessageMessageList m_autoSendOutputMessages;
-	OutputMessageMessageList m_toAddQueue;
+	// connections that got messages queued by sendAll, flushed once at its end
+	std::vector<Connection_ptr> m_sendConnections;
+	std::vector<uint8_t*> m_freeBuffers[OUTPUT_BUFFER_CLASSES];
 	boost::recursive_mutex m_outputPoolLock;
 	uint64_t m_frameTime;
 	bool m_isOpen;
@@ -126,6 +126,8 @@ Player::Player(const std::string& _name, ProtocolGame* p)
 		inventoryAbilities[i] = false;
 	}
 
+	saveSections = PLAYERSAVE_ALL;
+
 	for (int32_t i = SKILL_FIRST; i <= SKILL_LAST; ++i)
 	{
 		skills[i][SKILL_LEVEL] = 10;
@@ -1027,6 +1029,8 @@ void Player::addSkillAdvance(const skills_t& skill, const uint32_t& count, bool
 		skills[skill][SKILL_TRIES] += count * g_config.getNumber(ConfigManager::RATE_SKILL);
 	}
 
+	setSaveDirty(PLAYERSAVE_SKILLS);
+
 #ifdef __DEBUG__
 	std::cout << getName() << ", has the vocation: " << (int)getVocationId() << " and is training his " << Player::getSkillName(skill) << "(" << skill << "). Tries: " << skills[skill][SKILL_TRIES] << "(" << vocation->getReqSkillTries(skill, skills[skill][SKILL_LEVEL] + 1) << ")" << std::endl;
 	std::cout << "Current skill: " << skills[skill][SKILL_LEVEL] << std::endl;
@@ -1347,6 +1351,7 @@ void Player::addStorageValue(const uint32_t& key, const int32_t& value)
 	else
 	{
 		storageMap[key] = value;
+		setSaveDirty(PLAYERSAVE_STORAGE);
 	}
 }
 
@@ -1380,6 +1385,7 @@ bool Player::eraseStorageValue(const uint32_t& key)
 	if (it != storageMap.end())
 	{
 		storageMap.erase(it);
+		setSaveDirty(PLAYERSAVE_STORAGE);
 		return(true);
 	}
 
@@ -1520,8 +1526,7 @@ bool Player::canWalkthrough(const Creature* creature) const
 		return true;
 	}
 
-	if (creature->getTile() && creature->getTile()->ground
-	        && creature->getTile()->ground->getID() == ITEM_GLOWING_SWITCH)
+	if (creature->getTile() && creature->getTile()->getGroundId() == ITEM_GLOWING_SWITCH)
 	{
 		return false;
 	}
@@ -1697,6 +1702,7 @@ bool Player::addDepot(Depot* depot, const uint32_t& depotId)
 
 	depots[depotId] = depot;
 	depot->setMaxDepotLimit(maxDepotLimit);
+	setSaveDirty(PLAYERSAVE_DEPOTS);
 	return true;
 }
 
@@ -3618,6 +3624,8 @@ void Player::die()
 
 				skills[i][SKILL_TRIES] = std::max((int32_t)0, (int32_t)(skills[i][SKILL_TRIES] - lostSkillTries));
 			}
+
+			setSaveDirty(PLAYERSAVE_SKILLS);
 		}
 
 		Creature::die();
@@ -3928,6 +3936,7 @@ bool Player::removeVIP(const uint32_t& _guid)
 	if (it != VIPList.end())
 	{
 		VIPList.erase(it);
+		setSaveDirty(PLAYERSAVE_VIP);
 		return true;
 	}
 
@@ -3969,6 +3978,7 @@ bool Player::addVIP(const uint32_t& _guid, std::string& name, bool isOnline, boo
 	}
 
 	VIPList.insert(_guid);
+	setSaveDirty(PLAYERSAVE_VIP);
 
 	if (client && !internal)
 	{
@@ -4971,6 +4981,7 @@ void Player::postAddNotification(Thing* thing, const Cylinder* oldParent, int32_
 
 	if (link == LINK_OWNER || link == LINK_TOPPARENT)
 	{
+		setSaveDirty(PLAYERSAVE_INVENTORY);
 		const Item* i = (oldParent ? oldParent->getItem() : NULL);
 		// Check if we owned the old container too, so we don't need to do anything,
 		// as the list was updated in postRemoveNotification
@@ -5037,6 +5048,7 @@ void Player::postRemoveNotification(Thing* thing, const Cylinder* newParent, int
 
 	if (link == LINK_OWNER || link == LINK_TOPPARENT)
 	{
+		setSaveDirty(PLAYERSAVE_INVENTORY);
 		const Item* i = (newParent ? newParent->getItem() : NULL);
 		// Check if we owned the old container too, so we don't need to do anything,
 		// as the list was updated in postRemoveNotification
@@ -5454,6 +5466,7 @@ void Player::updateItemsLight(bool internal /*=false*/)
 void Player::onAddCondition(const ConditionType_t& type, bool hadCondition)
 {
 	Creature::onAddCondition(type, hadCondition);
+	setSaveDirty(PLAYERSAVE_CONDITIONS);
 	sendIcons();
 }
 
@@ -5480,6 +5493,7 @@ void Player::onAddCombatCondition(const ConditionType_t& type, bool hadCondition
 void Player::onEndCondition(const ConditionType_t& type, bool lastCondition)
 {
 	Creature::onEndCondition(type, lastCondition);
+	setSaveDirty(PLAYERSAVE_CONDITIONS);
 
 	if (type == CONDITION_INFIGHT)
 	{
@@ -6262,11 +6276,13 @@ bool Player::addOutfit(const uint32_t& outfitId, const uint32_t& addons)
 			outfit.addons |= it->second.addons;
 			outfit.addons |= addons;
 			outfits[outfitId] = outfit;
+			setSaveDirty(PLAYERSAVE_STORAGE);
 			return true;
 		}
 
 		outfit.addons |= addons;
 		outfits[outfitId] = outfit;
+		setSaveDirty(PLAYERSAVE_STORAGE);
 		return true;
 	}
 	else
@@ -6294,6 +6310,7 @@ bool Player::removeOutfit(const uint32_t& outfitId, const uint32_t& addons)
 			outfits[outfitId].addons = it->second.addons & (~addons);
 		}
 
+		setSaveDirty(PLAYERSAVE_STORAGE);
 		return true;
 	}
 
@@ -6356,6 +6373,44 @@ void Player::genReservedStorageRange()
 	}
 }
 
+void Player::clearSaveDirty()
+{
+	saveSections = PLAYERSAVE_NONE;
+
+	for (DepotMap::iterator it = depots.begin(); it != depots.end(); ++it)
+	{
+		it->second->setSaveDirty(false);
+	}
+}
+
+//static
+void Player::setItemSaveDirty(const Item* item)
+{
+	const Cylinder* topParent = item->getTopParent();
+
+	if (!topParent)
+	{
+		return;
+	}
+
+	if (const Creature* creature = topParent->getCreature())
+	{
+		if (const Player* player = creature->getPlayer())
+		{
+			const_cast<Player*>(player)->setSaveDirty(PLAYERSAVE_INVENTORY);
+		}
+	}
+	else if (const Item* topItem = topParent->getItem())
+	{
+		const Container* container = topItem->getContainer();
+
+		if (container && container->getDepot())
+		{
+			const_cast<Depot*>(container->getDepot())->setSaveDirty(true);
+		}
+	}
+}
+
 bool Player::canLogout()
 {
 	if (isConnecting)
@@ -6386,6 +6441,7 @@ void Player::learnInstantSpell(const std::string& name)
 	if (!hasLearnedInstantSpell(name))
 	{
 		learnedInstantSpellList.push_back(name);
+		setSaveDirty(PLAYERSAVE_SPELLS);
 	}
 }
 
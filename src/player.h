@@ -92,6 +92,20 @@ enum tradestate_t
 	TRADE_TRANSFER
 };
 
+//sections of the player that changed since the last save
+enum playersave_t
+{
+	PLAYERSAVE_NONE = 0,
+	PLAYERSAVE_SKILLS = 1 << 0,
+	PLAYERSAVE_STORAGE = 1 << 1,
+	PLAYERSAVE_INVENTORY = 1 << 2,
+	PLAYERSAVE_DEPOTS = 1 << 3,
+	PLAYERSAVE_CONDITIONS = 1 << 4,
+	PLAYERSAVE_VIP = 1 << 5,
+	PLAYERSAVE_SPELLS = 1 << 6,
+	PLAYERSAVE_ALL = (1 << 7) - 1
+};
+
 typedef std::pair<uint32_t, Container*> containervector_pair;
 typedef std::vector<containervector_pair> ContainerVector;
 typedef std::map<uint32_t, Depot*> DepotMap;
@@ -185,6 +199,17 @@ public:
 	static bool eraseStorageValueByName(const std::string& name, const uint32_t& key);
 	void genReservedStorageRange();
 
+	void setSaveDirty(const uint32_t& sections)
+	{
+		saveSections |= sections;
+	}
+	bool isSaveDirty(const uint32_t& sections) const
+	{
+		return (saveSections & sections) != 0;
+	}
+	void clearSaveDirty();
+	static void setItemSaveDirty(const Item* item);
+
 	bool withdrawMoney(const uint32_t& amount);
 	bool depositMoney(const uint32_t& amount);
 	bool transferMoneyTo(const std::string& name, const uint32_t& amount);
@@ -718,6 +743,8 @@ protected:
 
 	ConditionList storedConditionList;
 
+	uint32_t saveSections;
+
 	//trade variables
 	Player* tradePartner;
 	tradestate_t tradeState;
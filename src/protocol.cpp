@@ -23,6 +23,10 @@
 #include <winerror.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "protocol.h"
 #include "scheduler.h"
 #include "connection.h"
@@ -117,84 +121,134 @@ void Protocol::deleteProtocolTask()
 	delete this;
 }
 
-void Protocol::XTEA_encrypt(OutputMessage& msg)
+#define XTEA_DELTA 0x9E3779B9
+
+void Protocol::setXTEAKey(const uint32_t* key)
 {
-	uint32_t k[4];
-	k[0] = m_key[0];
-	k[1] = m_key[1];
-	k[2] = m_key[2];
-	k[3] = m_key[3];
-	int32_t messageLength = msg.getMessageLength();
-	//add bytes until reach 8 multiple
-	uint32_t n;
+	uint32_t sum = 0;
 
-	if ((messageLength % 8) != 0)
+	for (int32_t i = 0; i < XTEA_ROUNDS; ++i)
 	{
-		n = 8 - (messageLength % 8);
-		msg.AddPaddingBytes(n);
-		messageLength = messageLength + n;
+		m_roundKeys[i * 2] = sum + key[sum & 3];
+		sum += XTEA_DELTA;
+		m_roundKeys[i * 2 + 1] = sum + key[sum >> 11 & 3];
+	}
+}
+
+// blocks are independent of each other, with SSE2 four of them go through
+// the rounds together, one per 32 bit lane
+static void XTEA_encryptBlocks(uint32_t* buffer, int32_t blocks, const uint32_t* roundKeys)
+{
+	int32_t block = 0;
+#ifdef __SSE2__
+
+	for (; block + 4 <= blocks; block += 4)
+	{
+		__m128i* data = (__m128i*)(buffer + block * 2);
+		__m128i a = _mm_shuffle_epi32(_mm_loadu_si128(data), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i b = _mm_shuffle_epi32(_mm_loadu_si128(data + 1), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(a, b);
+		__m128i v1 = _mm_unpackhi_epi64(a, b);
+
+		for (int32_t i = 0; i < XTEA_ROUNDS; ++i)
+		{
+			__m128i f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_add_epi32(v0, _mm_xor_si128(f, _mm_set1_epi32(roundKeys[i * 2])));
+			f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_add_epi32(v1, _mm_xor_si128(f, _mm_set1_epi32(roundKeys[i * 2 + 1])));
+		}
+
+		_mm_storeu_si128(data, _mm_shuffle_epi32(_mm_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm_storeu_si128(data + 1, _mm_shuffle_epi32(_mm_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0)));
 	}
 
-	int read_pos = 0;
-	uint32_t* buffer = (uint32_t*)msg.getOutputBuffer();
+#endif
 
-	while (read_pos < messageLength / 4)
+	for (; block < blocks; ++block)
 	{
-		uint32_t v0 = buffer[read_pos], v1 = buffer[read_pos + 1];
-		uint32_t delta = 0x61C88647;
-		uint32_t sum = 0;
+		uint32_t v0 = buffer[block * 2], v1 = buffer[block * 2 + 1];
 
-		for (int32_t i = 0; i < 32; ++i)
+		for (int32_t i = 0; i < XTEA_ROUNDS; ++i)
 		{
-			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^(sum + k[sum & 3]);
-			sum -= delta;
-			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^(sum + k[sum >> 11 & 3]);
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[i * 2];
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[i * 2 + 1];
 		}
 
-		buffer[read_pos] = v0;
-		buffer[read_pos + 1] = v1;
-		read_pos = read_pos + 2;
+		buffer[block * 2] = v0;
+		buffer[block * 2 + 1] = v1;
 	}
 }
 
-bool Protocol::XTEA_decrypt(NetworkMessage& msg)
+static void XTEA_decryptBlocks(uint32_t* buffer, int32_t blocks, const uint32_t* roundKeys)
 {
-	if ((msg.getMessageLength() - 6) % 8 != 0)
+	int32_t block = 0;
+#ifdef __SSE2__
+
+	for (; block + 4 <= blocks; block += 4)
 	{
-#ifdef __DEBUG_NET_DETAIL__
-		std::cout << "Failure: [Protocol::XTEA_decrypt]. Not valid encrypted message size" << std::endl;
-#endif
-		return false;
+		__m128i* data = (__m128i*)(buffer + block * 2);
+		__m128i a = _mm_shuffle_epi32(_mm_loadu_si128(data), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i b = _mm_shuffle_epi32(_mm_loadu_si128(data + 1), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(a, b);
+		__m128i v1 = _mm_unpackhi_epi64(a, b);
+
+		for (int32_t i = XTEA_ROUNDS - 1; i >= 0; --i)
+		{
+			__m128i f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_sub_epi32(v1, _mm_xor_si128(f, _mm_set1_epi32(roundKeys[i * 2 + 1])));
+			f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_sub_epi32(v0, _mm_xor_si128(f, _mm_set1_epi32(roundKeys[i * 2])));
+		}
+
+		_mm_storeu_si128(data, _mm_shuffle_epi32(_mm_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm_storeu_si128(data + 1, _mm_shuffle_epi32(_mm_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0)));
 	}
 
-	//
-	uint32_t k[4];
-	k[0] = m_key[0];
-	k[1] = m_key[1];
-	k[2] = m_key[2];
-	k[3] = m_key[3];
-	uint32_t* buffer = (uint32_t*)(msg.getBuffer() + msg.getReadPos());
-	int read_pos = 0;
-	int32_t messageLength = msg.getMessageLength() - 6;
+#endif
 
-	while (read_pos < messageLength / 4)
+	for (; block < blocks; ++block)
 	{
-		uint32_t v0 = buffer[read_pos], v1 = buffer[read_pos + 1];
-		uint32_t delta = 0x61C88647;
-		uint32_t sum = 0xC6EF3720;
+		uint32_t v0 = buffer[block * 2], v1 = buffer[block * 2 + 1];
 
-		for (int32_t i = 0; i < 32; ++i)
+		for (int32_t i = XTEA_ROUNDS - 1; i >= 0; --i)
 		{
-			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^(sum + k[sum >> 11 & 3]);
-			sum += delta;
-			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^(sum + k[sum & 3]);
+			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[i * 2 + 1];
+			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[i * 2];
 		}
 
-		buffer[read_pos] = v0;
-		buffer[read_pos + 1] = v1;
-		read_pos = read_pos + 2;
+		buffer[block * 2] = v0;
+		buffer[block * 2 + 1] = v1;
 	}
+}
+
+void Protocol::XTEA_encrypt(OutputMessage& msg)
+{
+	int32_t messageLength = msg.getMessageLength();
+	//add bytes until reach 8 multiple
+	uint32_t n;
 
+	if ((messageLength % 8) != 0)
+	{
+		n = 8 - (messageLength % 8);
+		msg.AddPaddingBytes(n);
+		messageLength = messageLength + n;
+	}
+
+	XTEA_encryptBlocks((uint32_t*)msg.getOutputBuffer(), messageLength / 8, m_roundKeys);
+}
+
+bool Protocol::XTEA_decrypt(NetworkMessage& msg)
+{
+	if ((msg.getMessageLength() - 6) % 8 != 0)
+	{
+#ifdef __DEBUG_NET_DETAIL__
+		std::cout << "Failure: [Protocol::XTEA_decrypt]. Not valid encrypted message size" << std::endl;
+#endif
+		return false;
+	}
+
+	int32_t messageLength = msg.getMessageLength() - 6;
+	XTEA_decryptBlocks((uint32_t*)(msg.getBuffer() + msg.getReadPos()), messageLength / 8, m_roundKeys);
 	//
 	int tmp = msg.GetU16();
 
@@ -34,6 +34,8 @@ typedef boost::shared_ptr<OutputMessage> OutputMessage_ptr;
 typedef boost::shared_ptr<Connection> Connection_ptr;
 class RSA;
 
+#define XTEA_ROUNDS 32
+
 #define CLIENT_VERSION_MIN 861
 #define CLIENT_VERSION_MAX 861
 
@@ -48,10 +50,8 @@ public:
 		m_encryptionEnabled = false;
 		m_checksumEnabled = false;
 		m_rawMessages = false;
-		m_key[0] = 0;
-		m_key[1] = 0;
-		m_key[2] = 0;
-		m_key[3] = 0;
+		const uint32_t key[4] = {0, 0, 0, 0};
+		setXTEAKey(key);
 		m_refCount = 0;
 	}
 
@@ -99,10 +99,7 @@ protected:
 	{
 		m_encryptionEnabled = false;
 	}
-	void setXTEAKey(const uint32_t* key)
-	{
-		memcpy(&m_key, key, sizeof(uint32_t) * 4);
-	}
+	void setXTEAKey(const uint32_t* key);
 	void enableChecksum()
 	{
 		m_checksumEnabled = true;
@@ -132,7 +129,8 @@ private:
 	bool m_encryptionEnabled;
 	bool m_checksumEnabled;
 	bool m_rawMessages;
-	uint32_t m_key[4];
+	// the key mixed with the round sums, two per round
+	uint32_t m_roundKeys[XTEA_ROUNDS * 2];
 	uint32_t m_refCount;
 };
 
@@ -56,6 +56,13 @@ Chat g_chat;
 uint32_t ProtocolGame::protocolGameCount = 0;
 #endif
 
+// entries kept before the tile description cache is emptied
+#define TILE_ITEMS_CACHE_SIZE 65536
+
+ProtocolGame::TileItemsDescriptionCache ProtocolGame::tileItemsCache;
+bool ProtocolGame::broadcasting = false;
+std::string ProtocolGame::broadcastBody;
+
 // Helping templates to add dispatcher tasks
 
 template<class FunctionType>
@@ -665,33 +672,183 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 	}
 }
 
-void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
+static uint32_t encodeItemId(uint8_t* buffer, uint16_t itemId)
 {
-	if (tile)
+	const ItemType& it = Item::items[itemId];
+	buffer[0] = (uint8_t)it.clientId;
+	buffer[1] = (uint8_t)(it.clientId >> 8);
+	return 2;
+}
+
+// same bytes as NetworkMessage::AddItem
+static uint32_t encodeTileItem(uint8_t* buffer, const Item* item)
+{
+	const ItemType& it = Item::items[item->getID()];
+	encodeItemId(buffer, item->getID());
+
+	if (it.stackable)
+	{
+		buffer[2] = (uint8_t)item->getSubType();
+		return 3;
+	}
+	else if (it.isSplash() || it.isFluidContainer())
 	{
-		int count = 0;
+		buffer[2] = (uint8_t)ItemType::getClientFluidType(FluidTypes_t(item->getSubType()));
+		return 3;
+	}
+
+	return 2;
+}
 
-		if (tile->ground)
+void ProtocolGame::describeTileItems(const Tile* tile, TileItemsDescription& description)
+{
+	// a tile shows 10 things at most, so there are never more items to encode
+	uint32_t size = 0;
+	description.topCount = 0;
+	description.downCount = 0;
+
+	if (tile->hasPackedItems())
+	{
+		// packed items are never stackable nor fluids, so only the client id is sent
+		if (uint16_t groundId = tile->getGroundId())
 		{
-			msg->AddItem(tile->ground);
-			count++;
+			size += encodeItemId(description.bytes + size, groundId);
+			++description.topCount;
 		}
 
-		const TileItemVector* items = tile->getItemList();
+		uint32_t itemCount = tile->getItemCount();
+		uint32_t downItemCount = tile->getDownItemCount();
 
-		const CreatureVector* creatures = tile->getCreatures();
+		for (uint32_t i = downItemCount; i < itemCount && description.topCount < 10; ++i)
+		{
+			size += encodeItemId(description.bytes + size, tile->getPackedItemId(i));
+			++description.topCount;
+		}
 
-		ItemVector::const_iterator it;
+		description.topEnd = size;
 
-		if (items)
+		for (uint32_t i = 0; i < downItemCount && description.topCount + description.downCount < 10; ++i)
 		{
-			for (it = items->getBeginTopItem(); ((it != items->getEndTopItem()) && (count < 10)); ++it)
-			{
-				msg->AddItem(*it);
-				count++;
-			}
+			size += encodeItemId(description.bytes + size, tile->getPackedItemId(i));
+			description.downEnds[description.downCount++] = size;
 		}
 
+		return;
+	}
+
+	if (tile->getGround())
+	{
+		size += encodeTileItem(description.bytes + size, tile->getGround());
+		++description.topCount;
+	}
+
+	const TileItemVector* items = tile->getItemList();
+
+	if (items)
+	{
+		for (ItemVector::const_iterator it = items->getBeginTopItem();
+		        it != items->getEndTopItem() && description.topCount < 10; ++it)
+		{
+			size += encodeTileItem(description.bytes + size, *it);
+			++description.topCount;
+		}
+	}
+
+	description.topEnd = size;
+
+	if (items)
+	{
+		for (ItemVector::const_iterator it = items->getBeginDownItem();
+		        it != items->getEndDownItem() && description.topCount + description.downCount < 10; ++it)
+		{
+			size += encodeTileItem(description.bytes + size, *it);
+			description.downEnds[description.downCount++] = size;
+		}
+	}
+}
+
+const ProtocolGame::TileItemsDescription& ProtocolGame::getTileItemsDescription(const Tile* tile)
+{
+	Floor* floor = (tile->qt_node ? tile->qt_node->getFloor(tile->getPosition().z) : NULL);
+
+	if (!floor)
+	{
+		static TileItemsDescription description;
+		describeTileItems(tile, description);
+		return description;
+	}
+
+	TileItemsDescriptionCache::iterator it = tileItemsCache.find(tile);
+
+	if (it != tileItemsCache.end())
+	{
+		if (it->second.version != floor->version)
+		{
+			describeTileItems(tile, it->second);
+			it->second.version = floor->version;
+		}
+
+		return it->second;
+	}
+
+	if (tileItemsCache.size() >= TILE_ITEMS_CACHE_SIZE)
+	{
+		tileItemsCache.clear();
+	}
+
+	TileItemsDescription& description = tileItemsCache[tile];
+	describeTileItems(tile, description);
+	description.version = floor->version;
+	return description;
+}
+
+ProtocolGame::Broadcast::Broadcast()
+{
+	assert(!broadcasting);
+	broadcasting = true;
+}
+
+ProtocolGame::Broadcast::~Broadcast()
+{
+	broadcasting = false;
+	broadcastBody.clear();
+}
+
+bool ProtocolGame::addBroadcastBody(NetworkMessage_ptr msg)
+{
+	if (!broadcasting || broadcastBody.empty())
+	{
+		return false;
+	}
+
+	msg->AddBytes(broadcastBody.data(), broadcastBody.size());
+	return true;
+}
+
+void ProtocolGame::setBroadcastBody(NetworkMessage_ptr msg, const int32_t& start)
+{
+	if (broadcasting)
+	{
+		int32_t length = msg->getMessageLength() - start;
+		broadcastBody.assign(msg->getBuffer() + msg->getReadPos() - length, length);
+	}
+}
+
+void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
+{
+	if (tile)
+	{
+		// the items are the same for everyone, only the creatures depend on the player
+		const TileItemsDescription& description = getTileItemsDescription(tile);
+		int count = description.topCount;
+
+		if (description.topEnd > 0)
+		{
+			msg->AddBytes((const char*)description.bytes, description.topEnd);
+		}
+
+		const CreatureVector* creatures = tile->getCreatures();
+
 		if (creatures)
 		{
 			CreatureVector::const_reverse_iterator cit;
@@ -709,13 +866,12 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
 			}
 		}
 
-		if (items)
+		int downCount = std::min(10 - count, (int)description.downCount);
+
+		if (downCount > 0)
 		{
-			for (it = items->getBeginDownItem(); ((it != items->getEndDownItem()) && (count < 10)); ++it)
-			{
-				msg->AddItem(*it);
-				count++;
-			}
+			msg->AddBytes((const char*)description.bytes + description.topEnd,
+			              description.downEnds[downCount - 1] - description.topEnd);
 		}
 	}
 }
@@ -2033,7 +2189,13 @@ void ProtocolGame::sendCreatureSay(const Creature* creature, SpeakClasses type,
 	if (msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddCreatureSpeak(msg, creature, type, text, 0);
+
+		if (!addBroadcastBody(msg))
+		{
+			int32_t start = msg->getMessageLength();
+			AddCreatureSpeak(msg, creature, type, text, 0);
+			setBroadcastBody(msg, start);
+		}
 	}
 }
 
@@ -2130,7 +2292,13 @@ void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, u
 		if (msg)
 		{
 			TRACK_MESSAGE(msg);
-			AddDistanceShoot(msg, from, to, type);
+
+			if (!addBroadcastBody(msg))
+			{
+				int32_t start = msg->getMessageLength();
+				AddDistanceShoot(msg, from, to, type);
+				setBroadcastBody(msg, start);
+			}
 		}
 	}
 }
@@ -2144,7 +2312,13 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 		if (msg)
 		{
 			TRACK_MESSAGE(msg);
-			AddMagicEffect(msg, pos, type);
+
+			if (!addBroadcastBody(msg))
+			{
+				int32_t start = msg->getMessageLength();
+				AddMagicEffect(msg, pos, type);
+				setBroadcastBody(msg, start);
+			}
 		}
 	}
 }
@@ -2158,7 +2332,13 @@ void ProtocolGame::sendAnimatedText(const Position& pos, uint8_t color, std::str
 		if (msg)
 		{
 			TRACK_MESSAGE(msg);
-			AddAnimatedText(msg, pos, color, text);
+
+			if (!addBroadcastBody(msg))
+			{
+				int32_t start = msg->getMessageLength();
+				AddAnimatedText(msg, pos, color, text);
+				setBroadcastBody(msg, start);
+			}
 		}
 	}
 }
@@ -2172,7 +2352,13 @@ void ProtocolGame::sendCreatureHealth(const Creature* creature)
 		if (msg)
 		{
 			TRACK_MESSAGE(msg);
-			AddCreatureHealth(msg, creature);
+
+			if (!addBroadcastBody(msg))
+			{
+				int32_t start = msg->getMessageLength();
+				AddCreatureHealth(msg, creature);
+				setBroadcastBody(msg, start);
+			}
 		}
 	}
 }
@@ -70,9 +70,44 @@ public:
 
 	void setPlayer(Player* p);
 
+	// While a broadcast exists the packets its players are sent are encoded
+	// for the first of them only, the others get a copy of those bytes
+	class Broadcast : boost::noncopyable
+	{
+	public:
+		Broadcast();
+		~Broadcast();
+	};
+
 private:
 	std::list<uint32_t> knownCreatureList;
 
+	// The items of a tile encoded for the client, shared by all players.
+	// Entries are only valid for the version of the tile's floor they were
+	// made for. Ground and top items come first, then the down items.
+	struct TileItemsDescription
+	{
+		uint32_t version;
+		uint8_t topCount;
+		uint8_t downCount;
+		// end of the top items and of every down item in bytes
+		uint8_t topEnd;
+		uint8_t downEnds[10];
+		// 3 bytes per item at most
+		uint8_t bytes[30];
+	};
+
+	typedef std::unordered_map<const Tile*, TileItemsDescription> TileItemsDescriptionCache;
+	static TileItemsDescriptionCache tileItemsCache;
+	static void describeTileItems(const Tile* tile, TileItemsDescription& description);
+	static const TileItemsDescription& getTileItemsDescription(const Tile* tile);
+
+	static bool broadcasting;
+	// empty until the first player of the broadcast was sent the packet
+	static std::string broadcastBody;
+	bool addBroadcastBody(NetworkMessage_ptr msg);
+	void setBroadcastBody(NetworkMessage_ptr msg, const int32_t& start);
+
 	bool connect(uint32_t playerId);
 	void disconnectClient(uint8_t error, const char* message);
 	void disconnect();
@@ -26,6 +26,10 @@
 SchedulerTask::SchedulerTask(const uint32_t& delay, const boost::function<void (void)>& f)
 	: Task(delay, f)
 	, m_eventid(0)
+	, m_tick(0)
+	, m_slot(NULL)
+	, m_prev(NULL)
+	, m_next(NULL)
 {}
 
 SchedulerTask::~SchedulerTask()
@@ -48,20 +52,32 @@ const boost::system_time& SchedulerTask::getCycle() const
 	return m_expiration;
 }
 
-bool SchedulerTask::operator<(const SchedulerTask& other) const
-{
-	return getCycle() > other.getCycle();
-}
-
 Scheduler::Scheduler()
 {
+	m_currentTick = 0;
+	m_eventCount = 0;
 	m_lastEventId = 0;
 	m_threadState = STATE_TERMINATED;
+
+	for (uint32_t level = 0; level < SCHEDULER_WHEEL_LEVELS; ++level)
+	{
+		for (uint32_t slot = 0; slot < SCHEDULER_WHEEL_SIZE; ++slot)
+		{
+			m_wheel[level][slot] = NULL;
+		}
+	}
+}
+
+int64_t Scheduler::getTick(const boost::system_time& time)
+{
+	static const boost::system_time epoch(boost::gregorian::date(1970, 1, 1));
+	return (time - epoch).total_milliseconds();
 }
 
 void Scheduler::start()
 {
 	m_threadState = STATE_RUNNING;
+	m_currentTick = getTick(boost::get_system_time());
 	boost::thread(boost::bind(&Scheduler::schedulerThread, (void*)this));
 }
 
@@ -72,16 +88,14 @@ void Scheduler::schedulerThread(void* p)
 	schedulerExceptionHandler.InstallHandler();
 	// NOTE: second argument defer_lock is to prevent from immediate locking
 	boost::unique_lock<boost::mutex> eventLockUnique(scheduler->m_eventLock, boost::defer_lock);
+	std::vector<SchedulerTask*> expired;
 
 	while (scheduler->m_threadState != STATE_TERMINATED)
 	{
-		SchedulerTask* task = NULL;
-		bool runTask = false;
-		bool ret = true;
 		// check if there are events waiting...
 		eventLockUnique.lock();
 
-		if (scheduler->m_eventList.empty())
+		if (scheduler->m_eventCount == 0)
 		{
 #ifdef __DEBUG_SCHEDULER__
 			std::cout << "Scheduler: No events" << std::endl;
@@ -90,10 +104,16 @@ void Scheduler::schedulerThread(void* p)
 		}
 		else
 		{
+			int64_t waitTicks = scheduler->getNextTick() - getTick(boost::get_system_time());
+
+			if (waitTicks > 0)
+			{
 #ifdef __DEBUG_SCHEDULER__
-			std::cout << "Scheduler: Waiting for event" << std::endl;
+				std::cout << "Scheduler: Waiting for event" << std::endl;
 #endif
-			ret = scheduler->m_eventSignal.timed_wait(eventLockUnique, scheduler->m_eventList.top()->getCycle());
+				scheduler->m_eventSignal.timed_wait(eventLockUnique,
+				                                    boost::get_system_time() + boost::posix_time::milliseconds(waitTicks));
+			}
 		}
 
 #ifdef __DEBUG_SCHEDULER__
@@ -101,46 +121,168 @@ void Scheduler::schedulerThread(void* p)
 #endif
 
 		// the mutex is locked again now...
-		if (!ret && (scheduler->m_threadState != STATE_TERMINATED))
+		if (scheduler->m_threadState != STATE_TERMINATED)
 		{
-			// ok we had a timeout, so there has to be an event we have to execute...
-			task = scheduler->m_eventList.top();
-			scheduler->m_eventList.pop();
-			// check if the event was stopped
-			EventIdSet::iterator it = scheduler->m_eventIds.find(task->getEventId());
-
-			if (it != scheduler->m_eventIds.end())
-			{
-				// was not stopped so we should run it
-				runTask = true;
-				scheduler->m_eventIds.erase(it);
-			}
+			scheduler->advance(getTick(boost::get_system_time()), expired);
 		}
 
 		eventLockUnique.unlock();
 
-		// add task to dispatcher
-		if (task)
+		// add tasks to dispatcher
+		for (std::vector<SchedulerTask*>::iterator it = expired.begin(); it != expired.end(); ++it)
 		{
-			// if it was not stopped
-			if (runTask)
-			{
-				// Expiration has another meaning for dispatcher tasks, reset it
-				task->setDontExpire();
+			// Expiration has another meaning for dispatcher tasks, reset it
+			(*it)->setDontExpire();
 #ifdef __DEBUG_SCHEDULER__
-				std::cout << "Scheduler: Executing event " << task->getEventId() << std::endl;
+			std::cout << "Scheduler: Executing event " << (*it)->getEventId() << std::endl;
 #endif
-				g_dispatcher.addTask(task);
-			}
-			else
+			g_dispatcher.addTask(*it);
+		}
+
+		expired.clear();
+	}
+
+	schedulerExceptionHandler.RemoveHandler();
+}
+
+void Scheduler::linkEvent(SchedulerTask* task)
+{
+	int64_t tick = std::max(task->m_tick, m_currentTick);
+	int64_t delta = tick - m_currentTick;
+	uint32_t level = 0;
+
+	while (level < SCHEDULER_WHEEL_LEVELS && delta >= (int64_t(1) << (SCHEDULER_WHEEL_BITS * (level + 1))))
+	{
+		++level;
+	}
+
+	if (level == SCHEDULER_WHEEL_LEVELS)
+	{
+		// further away than the wheel reaches, it gets linked again when its slot cascades
+		level = SCHEDULER_WHEEL_LEVELS - 1;
+		tick = m_currentTick + (int64_t(1) << (SCHEDULER_WHEEL_BITS * SCHEDULER_WHEEL_LEVELS)) - 1;
+	}
+
+	SchedulerTask** slot = &m_wheel[level][(tick >> (SCHEDULER_WHEEL_BITS * level)) & SCHEDULER_WHEEL_MASK];
+	task->m_slot = slot;
+	task->m_prev = NULL;
+	task->m_next = *slot;
+
+	if (*slot)
+	{
+		(*slot)->m_prev = task;
+	}
+
+	*slot = task;
+}
+
+void Scheduler::unlinkEvent(SchedulerTask* task)
+{
+	if (task->m_prev)
+	{
+		task->m_prev->m_next = task->m_next;
+	}
+	else
+	{
+		*task->m_slot = task->m_next;
+	}
+
+	if (task->m_next)
+	{
+		task->m_next->m_prev = task->m_prev;
+	}
+
+	task->m_slot = NULL;
+	task->m_prev = NULL;
+	task->m_next = NULL;
+}
+
+bool Scheduler::cascadeEvents(const uint32_t& level)
+{
+	// moves the events of the slot that starts now down to the lower levels
+	uint32_t index = (m_currentTick >> (SCHEDULER_WHEEL_BITS * level)) & SCHEDULER_WHEEL_MASK;
+	SchedulerTask* task = m_wheel[level][index];
+	m_wheel[level][index] = NULL;
+
+	while (task)
+	{
+		SchedulerTask* next = task->m_next;
+		linkEvent(task);
+		task = next;
+	}
+
+	return index == 0;
+}
+
+void Scheduler::advance(const int64_t& tick, std::vector<SchedulerTask*>& expired)
+{
+	if (m_eventCount == 0)
+	{
+		m_currentTick = std::max(m_currentTick, tick + 1);
+		return;
+	}
+
+	while (m_currentTick <= tick)
+	{
+		uint32_t index = m_currentTick & SCHEDULER_WHEEL_MASK;
+
+		if (index == 0)
+		{
+			uint32_t level = 1;
+
+			while (level < SCHEDULER_WHEEL_LEVELS && cascadeEvents(level))
 			{
-				// was stopped, have to be deleted here
-				delete task;
+				++level;
 			}
 		}
+
+		SchedulerTask* task = m_wheel[0][index];
+		m_wheel[0][index] = NULL;
+
+		while (task)
+		{
+			SchedulerTask* next = task->m_next;
+			task->m_slot = NULL;
+			task->m_prev = NULL;
+			task->m_next = NULL;
+			releaseEventId(task);
+			expired.push_back(task);
+			task = next;
+		}
+
+		++m_currentTick;
 	}
+}
 
-	schedulerExceptionHandler.RemoveHandler();
+int64_t Scheduler::getNextTick() const
+{
+	// the first used slot of the current level 0 round, or the start of a
+	// round since the upper levels have to cascade first
+	int64_t tick = m_currentTick;
+
+	if ((tick & SCHEDULER_WHEEL_MASK) == 0)
+	{
+		return tick;
+	}
+
+	do
+	{
+		if (m_wheel[0][tick & SCHEDULER_WHEEL_MASK])
+		{
+			return tick;
+		}
+
+		++tick;
+	}
+	while (tick & SCHEDULER_WHEEL_MASK);
+
+	return tick;
+}
+
+void Scheduler::releaseEventId(SchedulerTask* task)
+{
+	m_events.erase(task->getEventId());
+	--m_eventCount;
 }
 
 uint32_t Scheduler::addEvent(SchedulerTask* task)
@@ -150,38 +292,47 @@ uint32_t Scheduler::addEvent(SchedulerTask* task)
 
 	if (Scheduler::m_threadState == Scheduler::STATE_RUNNING)
 	{
-		// check if the event has a valid id
-		if (task->getEventId() == 0)
+		// after a wrap around the ids of long running events are skipped
+		do
 		{
-			// if not generate one
-			if (m_lastEventId >= 0xFFFFFFFF)
-			{
-				m_lastEventId = 0;
-			}
-
 			++m_lastEventId;
-			task->setEventId(m_lastEventId);
+		}
+		while (m_lastEventId == 0 || m_events.find(m_lastEventId) != m_events.end());
+
+		task->setEventId(m_lastEventId);
+		task->m_tick = getTick(task->getCycle());
+		m_events[m_lastEventId] = task;
+
+		if (m_eventCount == 0)
+		{
+			// the wheel was idle, move it to the present
+			m_currentTick = std::max(m_currentTick, getTick(boost::get_system_time()));
+			do_signal = true;
+		}
+		else
+		{
+			// if the event is due before the scheduler thread wakes up we have to signal it
+			do_signal = task->m_tick < getNextTick();
 		}
 
-		// insert the eventid in the list of active events
-		m_eventIds.insert(task->getEventId());
-		// add the event to the queue
-		m_eventList.push(task);
-		// if the list was empty or this event is the top in the list
-		// we have to signal it
-		do_signal = (task == m_eventList.top());
+		++m_eventCount;
+		// add the event to the wheel
+		linkEvent(task);
 #ifdef __DEBUG_SCHEDULER__
 		std::cout << "Scheduler: Added event " << task->getEventId() << std::endl;
 #endif
 	}
-
-#ifdef __DEBUG_SCHEDULER__
 	else
 	{
+#ifdef __DEBUG_SCHEDULER__
 		std::cout << "Error: [Scheduler::addTask] Scheduler thread is terminated." << std::endl;
+#endif
+		m_eventLock.unlock();
+		delete task;
+		return 0;
 	}
 
-#endif
+	uint32_t eventId = task->getEventId();
 	m_eventLock.unlock();
 
 	if (do_signal)
@@ -189,7 +340,7 @@ uint32_t Scheduler::addEvent(SchedulerTask* task)
 		m_eventSignal.notify_one();
 	}
 
-	return task->getEventId();
+	return eventId;
 }
 
 
@@ -203,23 +354,21 @@ bool Scheduler::stopEvent(uint32_t eventid)
 #ifdef __DEBUG_SCHEDULER__
 	std::cout << "Scheduler: Stopping event " << eventid << std::endl;
 #endif
-	m_eventLock.lock();
-	// search the event id..
-	EventIdSet::iterator it = m_eventIds.find(eventid);
+	boost::mutex::scoped_lock lockClass(m_eventLock);
+	EventMap::iterator it = m_events.find(eventid);
 
-	if (it != m_eventIds.end())
-	{
-		// if it is found erase from the list
-		m_eventIds.erase(it);
-		m_eventLock.unlock();
-		return true;
-	}
-	else
+	if (it == m_events.end())
 	{
 		// this eventid is not valid
-		m_eventLock.unlock();
 		return false;
 	}
+
+	// stopped events leave the wheel right away
+	SchedulerTask* task = it->second;
+	unlinkEvent(task);
+	releaseEventId(task);
+	delete task;
+	return true;
 }
 
 void Scheduler::stop()
@@ -241,12 +390,14 @@ void Scheduler::shutdown()
 	m_threadState = Scheduler::STATE_TERMINATED;
 
 	//this list should already be empty
-	while (!m_eventList.empty())
+	for (EventMap::iterator it = m_events.begin(); it != m_events.end(); ++it)
 	{
-		m_eventList.pop();
+		unlinkEvent(it->second);
+		delete it->second;
 	}
 
-	m_eventIds.clear();
+	m_events.clear();
+	m_eventCount = 0;
 	m_eventLock.unlock();
+	m_eventSignal.notify_one();
 }
-
@@ -26,11 +26,17 @@
 #include "otsystem.h"
 #include <boost/bind.hpp>
 #include <vector>
-#include <queue>
-#include <set>
 
 #define SCHEDULER_MINTICKS 50
 
+// The scheduler keeps its events in a hierarchical timing wheel with
+// 1 ms ticks: SCHEDULER_WHEEL_LEVELS levels of SCHEDULER_WHEEL_SIZE slots,
+// each level covering SCHEDULER_WHEEL_SIZE times the range of the one below.
+#define SCHEDULER_WHEEL_BITS 8
+#define SCHEDULER_WHEEL_SIZE (1 << SCHEDULER_WHEEL_BITS)
+#define SCHEDULER_WHEEL_MASK (SCHEDULER_WHEEL_SIZE - 1)
+#define SCHEDULER_WHEEL_LEVELS 4
+
 class SchedulerTask : public Task
 {
 protected:
@@ -43,11 +49,17 @@ public:
 	const uint32_t& getEventId() const;
 
 	const boost::system_time& getCycle() const;
-	bool operator<(const SchedulerTask& other) const;
 
 protected:
 	uint32_t m_eventid;
 
+	// timing wheel links, only touched by the scheduler
+	int64_t m_tick;
+	SchedulerTask** m_slot;
+	SchedulerTask* m_prev;
+	SchedulerTask* m_next;
+
+	friend class Scheduler;
 	friend SchedulerTask* createSchedulerTask(const uint32_t&, const boost::function<void (void)>&);
 };
 
@@ -83,24 +95,29 @@ public:
 	};
 
 protected:
-
-	struct lessSchedTask : public std::binary_function<SchedulerTask*&, SchedulerTask*&, bool>
-	{
-		bool operator()(SchedulerTask*& t1, SchedulerTask*& t2) const
-		{
-			return (*t1) < (*t2);
-		}
-	};
-
 	static void schedulerThread(void* p);
+	static int64_t getTick(const boost::system_time& time);
+
+	void linkEvent(SchedulerTask* task);
+	void unlinkEvent(SchedulerTask* task);
+	bool cascadeEvents(const uint32_t& level);
+	void advance(const int64_t& tick, std::vector<SchedulerTask*>& expired);
+	int64_t getNextTick() const;
+	void releaseEventId(SchedulerTask* task);
 
 	boost::mutex m_eventLock;
 	boost::condition_variable m_eventSignal;
 
+	SchedulerTask* m_wheel[SCHEDULER_WHEEL_LEVELS][SCHEDULER_WHEEL_SIZE];
+	// next tick that has not been processed yet
+	int64_t m_currentTick;
+	uint32_t m_eventCount;
+
+	// active events by id, ids count up and 0 is never handed out since
+	// callers use it for "no event"
+	typedef std::unordered_map<uint32_t, SchedulerTask*> EventMap;
+	EventMap m_events;
 	uint32_t m_lastEventId;
-	std::priority_queue<SchedulerTask*, std::vector<SchedulerTask*>, lessSchedTask > m_eventList;
-	typedef std::set<uint32_t> EventIdSet;
-	EventIdSet m_eventIds;
 	SchedulerState m_threadState;
 };
 
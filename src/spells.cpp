@@ -43,6 +43,8 @@ Spells::Spells():
 	m_scriptInterface("Spell Interface")
 {
 	m_scriptInterface.initState();
+	WordsNode root = {0, 0, 0, NULL};
+	wordsTree.push_back(root);
 }
 
 Spells::~Spells()
@@ -127,6 +129,9 @@ void Spells::clear()
 	}
 
 	instants.clear();
+	wordsTree.resize(1);
+	wordsTree[0].child = 0;
+	wordsTree[0].spell = NULL;
 }
 
 LuaScriptInterface& Spells::getScriptInterface()
@@ -174,6 +179,7 @@ bool Spells::registerEvent(Event* event, xmlNodePtr p)
 		}
 
 		instants[instant->getWords()] = instant;
+		addInstantWords(instant);
 		return true;
 	}
 	else if (rune)
@@ -277,33 +283,75 @@ RuneSpell* Spells::getRuneSpellByName(const std::string& name)
 	return NULL;
 }
 
+void Spells::addInstantWords(InstantSpell* instant)
+{
+	const std::string& words = instant->getWords();
+	uint32_t node = 0;
+
+	for (std::string::const_iterator it = words.begin(); it != words.end(); ++it)
+	{
+		char c = tolower(*it);
+		uint32_t child = wordsTree[node].child;
+
+		while (child != 0 && wordsTree[child].c != c)
+		{
+			child = wordsTree[child].sibling;
+		}
+
+		if (child == 0)
+		{
+			WordsNode newNode = {c, 0, wordsTree[node].child, NULL};
+			child = wordsTree.size();
+			wordsTree.push_back(newNode);
+			wordsTree[node].child = child;
+		}
+
+		node = child;
+	}
+
+	// words only differing in case, the first one keeps them
+	if (!wordsTree[node].spell)
+	{
+		wordsTree[node].spell = instant;
+	}
+}
+
 InstantSpell* Spells::getInstantSpell(const std::string& words)
 {
-	InstantSpell* result = NULL;
+	// the spell with the longest words the text starts with
+	InstantSpell* result = wordsTree[0].spell;
+	size_t spellLen = 0;
+	uint32_t node = 0;
 
-	for (InstantsMap::iterator it = instants.begin(); it != instants.end(); ++it)
+	for (size_t i = 0; i < words.length(); ++i)
 	{
-		InstantSpell* instantSpell = it->second;
-		size_t spellLen = instantSpell->getWords().length();
+		char c = tolower(words[i]);
+		node = wordsTree[node].child;
 
-		if (asLowerCaseString(words).compare(0, spellLen, asLowerCaseString(instantSpell->getWords())) == 0)
+		while (node != 0 && wordsTree[node].c != c)
 		{
-			if (!result || spellLen > result->getWords().length())
-			{
-				result = instantSpell;
-			}
+			node = wordsTree[node].sibling;
+		}
+
+		if (node == 0)
+		{
+			break;
+		}
+
+		if (wordsTree[node].spell)
+		{
+			result = wordsTree[node].spell;
+			spellLen = i + 1;
 		}
 	}
 
 	if (result)
 	{
-		if (words.length() > result->getWords().length())
-		{
-			size_t spellLen = result->getWords().length();
-			size_t paramLen = words.length() - spellLen;
-			std::string paramText = words.substr(spellLen, paramLen);
+		size_t paramLen = words.length() - spellLen;
 
-			if (paramText.substr(0, 1) != " " || (paramText.length() >= 2 && paramText.substr(0, 2) != " \""))
+		if (paramLen > 0)
+		{
+			if (words[spellLen] != ' ' || (paramLen >= 2 && words[spellLen + 1] != '"'))
 			{
 				return NULL;
 			}
@@ -2154,11 +2202,11 @@ bool InstantSpell::Levitate(const InstantSpell* spell, Creature* creature, const
 		{
 			Tile* tmpTile = g_game.getTile(currentPos.x, currentPos.y, currentPos.z - 1);
 
-			if (!tmpTile || (!tmpTile->ground && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID)))
+			if (!tmpTile || (!tmpTile->hasGround() && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID)))
 			{
 				tmpTile = g_game.getTile(destPos.x, destPos.y, destPos.z - 1);
 
-				if (tmpTile && tmpTile->ground && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && !tmpTile->floorChange())
+				if (tmpTile && tmpTile->hasGround() && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && !tmpTile->floorChange())
 				{
 					ret = g_game.internalMoveCreature(player, player->getTile(),
 					                                  tmpTile, FLAG_IGNOREBLOCKITEM | FLAG_IGNOREBLOCKCREATURE);
@@ -2172,11 +2220,11 @@ bool InstantSpell::Levitate(const InstantSpell* spell, Creature* creature, const
 		{
 			Tile* tmpTile = g_game.getTile(destPos.x, destPos.y, destPos.z);
 
-			if (!tmpTile || (!tmpTile->ground && !tmpTile->hasProperty(BLOCKSOLID)))
+			if (!tmpTile || (!tmpTile->hasGround() && !tmpTile->hasProperty(BLOCKSOLID)))
 			{
 				tmpTile = g_game.getTile(destPos.x, destPos.y, destPos.z + 1);
 
-				if (tmpTile && tmpTile->ground && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && !tmpTile->floorChange())
+				if (tmpTile && tmpTile->hasGround() && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && !tmpTile->floorChange())
 				{
 					ret = g_game.internalMoveCreature(player, player->getTile(),
 					                                  tmpTile, FLAG_IGNOREBLOCKITEM | FLAG_IGNOREBLOCKCREATURE);
@@ -68,6 +68,20 @@ protected:
 	RunesMap runes;
 	InstantsMap instants;
 
+	// Case folded prefix tree over the words of the instant spells, node 0
+	// is the root. Children are kept as a list of siblings, an index of 0
+	// ends the list since the root is nobody's child.
+	struct WordsNode
+	{
+		char c;
+		uint32_t child;
+		uint32_t sibling;
+		InstantSpell* spell;
+	};
+
+	std::vector<WordsNode> wordsTree;
+	void addInstantWords(InstantSpell* instant);
+
 	friend class CombatSpell;
 	LuaScriptInterface m_scriptInterface;
 };
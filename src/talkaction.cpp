@@ -68,6 +68,9 @@ void TalkActions::clear()
 		it = wordsMap.begin();
 	}
 
+	quotationIndex.clear();
+	firstWordIndex.clear();
+
 	m_scriptInterface.reInitState();
 }
 
@@ -103,10 +106,44 @@ bool TalkActions::registerEvent(Event* event, xmlNodePtr p)
 		return false;
 	}
 
+	TalkActionIndex& index = (talkAction->getFilterType() == TALKACTION_MATCH_QUOTATION ? quotationIndex : firstWordIndex);
+	index[asLowerCaseString(talkAction->getWords())].push_back(std::make_pair(wordsMap.size(), talkAction));
 	wordsMap.push_back(std::make_pair(talkAction->getWords(), talkAction));
 	return true;
 }
 
+TalkAction* TalkActions::getTalkAction(const TalkActionIndex& index, const std::string& words,
+	const size_t& start, const size_t& length, uint32_t& order)
+{
+	// the first talkaction matching the command registered before order
+	std::string key(words, start, length);
+	toLowerCaseString(key);
+	TalkActionIndex::const_iterator it = index.find(key);
+
+	if (it == index.end())
+	{
+		return NULL;
+	}
+
+	for (TalkActionIndexList::const_iterator lit = it->second.begin(); lit != it->second.end(); ++lit)
+	{
+		if (lit->first >= order)
+		{
+			break;
+		}
+
+		TalkAction* talkAction = lit->second;
+
+		if (!talkAction->isCaseSensitive() || words.compare(start, length, talkAction->getWords()) == 0)
+		{
+			order = lit->first;
+			return talkAction;
+		}
+	}
+
+	return NULL;
+}
+
 TalkActionResult_t TalkActions::onPlayerSpeak(Player* player, SpeakClasses type, const std::string& words)
 {
 	if (type != SPEAK_SAY)
@@ -114,106 +151,84 @@ TalkActionResult_t TalkActions::onPlayerSpeak(Player* player, SpeakClasses type,
 		return TALKACTION_CONTINUE;
 	}
 
-	std::string str_words_quote;
-	std::string str_param_quote;
-	std::string str_words_first_word;
-	std::string str_param_first_word;
 	// With quotation filtering
-	size_t loc = words.find('"', 0);
+	size_t quoteLoc = words.find('"', 0);
+	size_t quoteStart = words.find_first_not_of(' ', 0);
+	size_t quoteEnd = (quoteLoc != std::string::npos ? quoteLoc : words.size());
 
-	if (loc != std::string::npos && loc >= 0)
-	{
-		str_words_quote = std::string(words, 0, loc);
-		str_param_quote = std::string(words, (loc + 1), words.size() - loc - 1);
-	}
-	else
+	if (quoteStart == std::string::npos || quoteStart > quoteEnd)
 	{
-		str_words_quote = words;
-		str_param_quote = std::string("");
+		quoteStart = quoteEnd;
 	}
 
-	trim_left(str_words_quote, " ");
-	trim_right(str_param_quote, " ");
 	// With whitespace filtering
-	loc = words.find(' ', 0);
+	size_t wordLoc = words.find(' ', 0);
+	size_t wordEnd = (wordLoc != std::string::npos ? wordLoc : words.size());
+	uint32_t order = wordsMap.size();
+	TalkAction* talkAction = getTalkAction(quotationIndex, words, quoteStart, quoteEnd - quoteStart, order);
+	TalkAction* firstWordAction = getTalkAction(firstWordIndex, words, 0, wordEnd, order);
+	std::string cmdstring;
+	std::string paramstring;
 
-	if (loc != std::string::npos && loc >= 0)
+	if (firstWordAction)
 	{
-		str_words_first_word = std::string(words, 0, loc);
-		str_param_first_word = std::string(words, (loc + 1), words.size() - loc - 1);
+		talkAction = firstWordAction;
+		cmdstring = std::string(words, 0, wordEnd);
+
+		if (wordLoc != std::string::npos)
+		{
+			paramstring = std::string(words, (wordLoc + 1), words.size() - wordLoc - 1);
+		}
+	}
+	else if (talkAction)
+	{
+		cmdstring = std::string(words, quoteStart, quoteEnd - quoteStart);
+
+		if (quoteLoc != std::string::npos)
+		{
+			paramstring = std::string(words, (quoteLoc + 1), words.size() - quoteLoc - 1);
+			trim_right(paramstring, " ");
+		}
 	}
 	else
 	{
-		str_words_first_word = words;
-		str_param_first_word = std::string("");
+		return TALKACTION_CONTINUE;
 	}
 
-	TalkActionList::iterator it;
+	bool ret = true;
 
-	for (it = wordsMap.begin(); it != wordsMap.end(); ++it)
+	if (player->getAccessLevel() < talkAction->getAccessLevel())
 	{
-		std::string cmdstring;
-		std::string paramstring;
-
-		if (it->second->getFilterType() == TALKACTION_MATCH_QUOTATION)
+		if (player->getAccessLevel() > 0)
 		{
-			cmdstring = str_words_quote;
-			paramstring = str_param_quote;
+			player->sendTextMessage(MSG_STATUS_SMALL, "You can not execute this command.");
+			ret = false;
 		}
-		else if (it->second->getFilterType() == TALKACTION_MATCH_FIRST_WORD)
+	}
+	else
+	{
+		if (talkAction->isScripted())
 		{
-			cmdstring = str_words_first_word;
-			paramstring = str_param_first_word;
+			ret = talkAction->executeSay(player, cmdstring, paramstring);
 		}
 		else
 		{
-			continue;
-		}
-
-		if (cmdstring == it->first || (!it->second->isCaseSensitive() && boost::algorithm::iequals(it->first, cmdstring)))
-		{
-			bool ret = true;
+			TalkActionFunction* func = talkAction->getFunction();
 
-			if (player->getAccessLevel() < it->second->getAccessLevel())
+			if (func)
 			{
-				if (player->getAccessLevel() > 0)
-				{
-					player->sendTextMessage(MSG_STATUS_SMALL, "You can not execute this command.");
-					ret = false;
-				}
-			}
-			else
-			{
-				TalkAction* talkAction = it->second;
-
-				if (talkAction->isScripted())
-				{
-					ret = talkAction->executeSay(player, cmdstring, paramstring);
-				}
-				else
-				{
-					TalkActionFunction* func = talkAction->getFunction();
-
-					if (func)
-					{
-						func(player, cmdstring, paramstring);
-						ret = false;
-					}
-				}
-			}
-
-			if (ret)
-			{
-				return TALKACTION_CONTINUE;
-			}
-			else
-			{
-				return TALKACTION_BREAK;
+				func(player, cmdstring, paramstring);
+				ret = false;
 			}
 		}
 	}
 
-	return TALKACTION_CONTINUE;
+	if (ret)
+	{
+		return TALKACTION_CONTINUE;
+	}
+
+	return TALKACTION_BREAK;
 }
 
 
@@ -490,6 +505,22 @@ bool TalkAction::serverDiag(Player* player, const std::string& words, const std:
 	text << "Player: " << g_game.getPlayersOnline() << " (" << Player::playerCount << ")\n";
 	text << "Npc: " << g_game.getNpcsOnline() << " (" << Npc::npcCount << ")\n";
 	text << "Monster: " << g_game.getMonstersOnline() << " (" << Monster::monsterCount << ")\n";
+	IOPlayer::PlayerSaveStats saveStats = IOPlayer::instance()->getSaveStats();
+	text << "\nPlayer saves:" << "\n";
+	text << "--------------------\n";
+	text << "Waiting for a snapshot: " << g_game.getPlayerSaveBacklog() << "\n";
+	text << "Waiting to be written: " << saveStats.pending << "\n";
+	text << "Written: " << saveStats.saved << " (" << saveStats.failed << " failed)\n";
+	text << "Write time: " << saveStats.lastWriteTime << " ms last, " << saveStats.maxWriteTime << " ms slowest, "
+	     << (saveStats.saved + saveStats.failed > 0 ? saveStats.totalWriteTime / (saveStats.saved + saveStats.failed) : 0) << " ms average\n";
+	text << "\nCreature checks:" << "\n";
+	text << "--------------------\n";
+
+	for (uint32_t i = 0; i < EVENT_CREATURECOUNT; ++i)
+	{
+		text << "Bucket " << i << ": " << g_game.getCheckCreatureCount(i) << " creatures, " << g_game.getCheckCreatureTime(i) << " us\n";
+	}
+
 	text << "\nProtocols:" << "\n";
 	text << "--------------------\n";
 	text << "ProtocolGame: " << ProtocolGame::protocolGameCount << "\n";
@@ -63,6 +63,16 @@ protected:
 	typedef std::list< std::pair<std::string, TalkAction* > > TalkActionList;
 	TalkActionList wordsMap;
 
+	// The talkactions of a filter type by their case folded words, each
+	// with its place in wordsMap since the first registered one wins
+	typedef std::vector< std::pair<uint32_t, TalkAction*> > TalkActionIndexList;
+	typedef std::unordered_map<std::string, TalkActionIndexList> TalkActionIndex;
+	TalkActionIndex quotationIndex;
+	TalkActionIndex firstWordIndex;
+
+	static TalkAction* getTalkAction(const TalkActionIndex& index, const std::string& words,
+		const size_t& start, const size_t& length, uint32_t& order);
+
 	LuaScriptInterface m_scriptInterface;
 };
 
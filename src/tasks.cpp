@@ -21,14 +21,22 @@
 
 #include "exception.h"
 #include "tasks.h"
+#include "otsystem.h"
 #include "outputmessage.h"
 #include "game.h"
 
+#include <boost/lockfree/stack.hpp>
+
 extern Game g_game;
 
+typedef boost::lockfree::stack<void*, boost::lockfree::capacity<DISPATCHER_TASK_POOL_SIZE> > TaskPool;
+static TaskPool taskPool;
+
 // DO NOT allocate this class on the stack
 Task::Task(const uint32_t& ms, const boost::function<void (void)>& f)
 	: m_f(f)
+	, m_next(NULL)
+	, m_enqueueTime(0)
 {
 	m_expiration = boost::get_system_time() + boost::posix_time::milliseconds(ms);
 }
@@ -36,6 +44,8 @@ Task::Task(const uint32_t& ms, const boost::function<void (void)>& f)
 Task::Task(const boost::function<void (void)>& f)
 	: m_expiration(boost::date_time::not_a_date_time)
 	, m_f(f)
+	, m_next(NULL)
+	, m_enqueueTime(0)
 {}
 
 Task::~Task()
@@ -43,6 +53,29 @@ Task::~Task()
 	// Virtual Destructor
 }
 
+void* Task::operator new(size_t size)
+{
+	void* p;
+
+	// derived tasks have another size and skip the pool
+	if (size == sizeof(Task) && taskPool.pop(p))
+	{
+		return p;
+	}
+
+	return ::operator new(size);
+}
+
+void Task::operator delete(void* p, size_t size)
+{
+	if (size == sizeof(Task) && taskPool.bounded_push(p))
+	{
+		return;
+	}
+
+	::operator delete(p);
+}
+
 void Task::operator()()
 {
 	m_f();
@@ -64,9 +97,20 @@ bool Task::hasExpired() const
 }
 
 Dispatcher::Dispatcher()
+	: m_sleeping(false)
+	, m_tasks(NULL)
+	, m_frontTasks(NULL)
+	, m_taskCount(0)
+	, m_threadState(STATE_TERMINATED)
+	, m_addingTasks(0)
 {
-	m_taskList.clear();
-	m_threadState = STATE_TERMINATED;
+	m_batch = NULL;
+	m_stats.executed = 0;
+	m_stats.queueDepth = 0;
+	m_stats.maxQueueDepth = 0;
+	m_stats.lastLatency = 0;
+	m_stats.maxLatency = 0;
+	m_stats.totalLatency = 0;
 }
 
 void Dispatcher::start()
@@ -83,112 +127,200 @@ void Dispatcher::dispatcherThread(void* p)
 #ifdef __DEBUG_SCHEDULER__
 	std::cout << "Starting Dispatcher" << std::endl;
 #endif
-	OutputMessagePool* outputPool;
 	// NOTE: second argument defer_lock is to prevent from immediate locking
 	boost::unique_lock<boost::mutex> taskLockUnique(dispatcher->m_taskLock, boost::defer_lock);
+	DispatcherStats stats;
+	stats.executed = 0;
 
 	while (dispatcher->m_threadState != STATE_TERMINATED)
 	{
-		Task* task = NULL;
-		// check if there are tasks waiting
-		taskLockUnique.lock();
+		Task* task = dispatcher->popTask();
 
-		if (dispatcher->m_taskList.empty())
+		if (!task)
 		{
-			//if the list is empty wait for signal
+			// nothing left, wait until a producer wakes us up. m_sleeping has to be
+			// set before checking the queues again so no signal gets lost
+			taskLockUnique.lock();
+			dispatcher->m_sleeping = true;
+
+			if (!dispatcher->hasTasks() && dispatcher->m_threadState != STATE_TERMINATED)
+			{
 #ifdef __DEBUG_SCHEDULER__
-			std::cout << "Dispatcher: Waiting for task" << std::endl;
+				std::cout << "Dispatcher: Waiting for task" << std::endl;
 #endif
-			dispatcher->m_taskSignal.wait(taskLockUnique);
-		}
+				dispatcher->m_taskSignal.wait(taskLockUnique);
+			}
 
+			dispatcher->m_sleeping = false;
+			taskLockUnique.unlock();
 #ifdef __DEBUG_SCHEDULER__
-		std::cout << "Dispatcher: Signalled" << std::endl;
+			std::cout << "Dispatcher: Signalled" << std::endl;
 #endif
+			continue;
+		}
 
-		if (!dispatcher->m_taskList.empty() && (dispatcher->m_threadState != STATE_TERMINATED))
+		if (stats.executed == 0)
 		{
-			// take the first task
-			task = dispatcher->m_taskList.front();
-			dispatcher->m_taskList.pop_front();
+			stats.queueDepth = dispatcher->m_taskCount;
+			stats.lastLatency = 0;
+			stats.maxLatency = 0;
+			stats.totalLatency = 0;
 		}
 
-		taskLockUnique.unlock();
+		dispatcher->executeTask(task, stats);
 
-		// finally execute the task...
-		if (task)
+		// publish the stats once the batch is done
+		if (!dispatcher->m_batch)
 		{
-			if (!task->hasExpired())
-			{
-				OutputMessagePool::getInstance()->startExecutionFrame();
-				(*task)();
-				outputPool = OutputMessagePool::getInstance();
+			dispatcher->updateStats(stats);
+			stats.executed = 0;
+		}
+	}
 
-				if (outputPool)
-				{
-					outputPool->sendAll();
-				}
+	dispatcherExceptionHandler.RemoveHandler();
+}
 
-				g_game.clearSpectatorCache();
-			}
+void Dispatcher::addTask(Task* task, bool push_front /*= false*/)
+{
+	++m_addingTasks;
 
-			delete task;
+	if (m_threadState != STATE_RUNNING)
+	{
+		--m_addingTasks;
 #ifdef __DEBUG_SCHEDULER__
-			std::cout << "Dispatcher: Executing task" << std::endl;
+		std::cout << "Error: [Dispatcher::addTask] Dispatcher thread is terminated." << std::endl;
 #endif
-		}
+		delete task;
+		return;
 	}
 
-	dispatcherExceptionHandler.RemoveHandler();
+	task->m_enqueueTime = OTSYS_TIME();
+	boost::atomic<Task*>& head = (push_front ? m_frontTasks : m_tasks);
+	Task* next = head.load(boost::memory_order_relaxed);
+
+	do
+	{
+		task->m_next = next;
+	}
+	while (!head.compare_exchange_weak(next, task));
+
+	++m_taskCount;
+	--m_addingTasks;
+#ifdef __DEBUG_SCHEDULER__
+	std::cout << "Dispatcher: Added task" << std::endl;
+#endif
+
+	// wake up the dispatcher if it went to sleep
+	if (m_sleeping)
+	{
+		m_taskLock.lock();
+		m_taskSignal.notify_one();
+		m_taskLock.unlock();
+	}
 }
 
-void Dispatcher::addTask(Task* task, bool push_front /*= false*/)
+bool Dispatcher::hasTasks() const
 {
-	bool do_signal = false;
-	m_taskLock.lock();
+	return m_batch || m_tasks.load() || m_frontTasks.load();
+}
 
-	if (m_threadState == STATE_RUNNING)
+Task* Dispatcher::popTask()
+{
+	if (m_frontTasks.load(boost::memory_order_relaxed))
 	{
-		do_signal = m_taskList.empty();
+		// tasks pushed to the front go before the rest of the batch,
+		// the latest one first
+		Task* front = m_frontTasks.exchange(NULL, boost::memory_order_acquire);
+		Task* last = front;
 
-		if (push_front)
+		while (last->m_next)
 		{
-			m_taskList.push_front(task);
+			last = last->m_next;
 		}
-		else
+
+		last->m_next = m_batch;
+		m_batch = front;
+	}
+
+	if (!m_batch && m_tasks.load(boost::memory_order_relaxed))
+	{
+		// take all queued tasks at once and restore their order
+		Task* task = m_tasks.exchange(NULL, boost::memory_order_acquire);
+
+		while (task)
 		{
-			m_taskList.push_back(task);
+			Task* next = task->m_next;
+			task->m_next = m_batch;
+			m_batch = task;
+			task = next;
 		}
-
-#ifdef __DEBUG_SCHEDULER__
-		std::cout << "Dispatcher: Added task" << std::endl;
-#endif
 	}
 
-#ifdef __DEBUG_SCHEDULER__
-	else
+	Task* task = m_batch;
+
+	if (task)
 	{
-		std::cout << "Error: [Dispatcher::addTask] Dispatcher thread is terminated." << std::endl;
+		m_batch = task->m_next;
+		task->m_next = NULL;
+		--m_taskCount;
 	}
 
-#endif
-	m_taskLock.unlock();
+	return task;
+}
 
-	// send a signal if the list was empty
-	if (do_signal)
+void Dispatcher::executeTask(Task* task, DispatcherStats& stats)
+{
+	int64_t latency = OTSYS_TIME() - task->m_enqueueTime;
+	stats.lastLatency = latency;
+	stats.maxLatency = std::max(stats.maxLatency, latency);
+	stats.totalLatency += latency;
+	++stats.executed;
+
+	if (!task->hasExpired())
 	{
-		m_taskSignal.notify_one();
+		OutputMessagePool::getInstance()->startExecutionFrame();
+		(*task)();
+		OutputMessagePool* outputPool = OutputMessagePool::getInstance();
+
+		if (outputPool)
+		{
+			outputPool->sendAll();
+		}
+
+		g_game.clearSpectatorCache();
+		g_game.clearSightCache();
 	}
+
+	delete task;
+#ifdef __DEBUG_SCHEDULER__
+	std::cout << "Dispatcher: Executing task" << std::endl;
+#endif
+}
+
+void Dispatcher::updateStats(const DispatcherStats& stats)
+{
+	boost::mutex::scoped_lock lockClass(m_taskLock);
+	m_stats.executed += stats.executed;
+	m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, stats.queueDepth);
+	m_stats.lastLatency = stats.lastLatency;
+	m_stats.maxLatency = std::max(m_stats.maxLatency, stats.maxLatency);
+	m_stats.totalLatency += stats.totalLatency;
+}
+
+DispatcherStats Dispatcher::getStats()
+{
+	boost::mutex::scoped_lock lockClass(m_taskLock);
+	DispatcherStats stats = m_stats;
+	stats.queueDepth = m_taskCount;
+	return stats;
 }
 
 void Dispatcher::flush()
 {
 	Task* task = NULL;
 
-	while (!m_taskList.empty())
+	while ((task = popTask()))
 	{
-		task = m_taskList.front();
-		m_taskList.pop_front();
 		(*task)();
 		delete task;
 		OutputMessagePool* outputPool = OutputMessagePool::getInstance();
@@ -199,6 +331,7 @@ void Dispatcher::flush()
 		}
 
 		g_game.clearSpectatorCache();
+		g_game.clearSightCache();
 	}
 
 #ifdef __DEBUG_SCHEDULER__
@@ -220,8 +353,16 @@ void Dispatcher::shutdown()
 {
 	m_taskLock.lock();
 	m_threadState = STATE_TERMINATED;
-	flush();
 	m_taskLock.unlock();
+
+	// producers that saw the dispatcher running may still be pushing
+	while (m_addingTasks > 0)
+	{
+		boost::this_thread::yield();
+	}
+
+	// shutdown runs as a dispatcher task, so this is still the only consumer
+	flush();
 #ifdef __DEBUG_SCHEDULER__
 	std::cout << "Shutdown Dispatcher" << std::endl;
 #endif
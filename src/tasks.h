@@ -25,8 +25,11 @@
 #include "definitions.h"
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 const int DISPATCHER_TASK_EXPIRATION = 2000;
+// how many freed tasks are kept around for reuse
+const uint32_t DISPATCHER_TASK_POOL_SIZE = 4096;
 
 class Task
 {
@@ -41,12 +44,22 @@ public:
 	void setDontExpire();
 	bool hasExpired() const;
 
+	// plain tasks are recycled through a lock-free pool
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 protected:
 	// Expiration has another meaning for scheduler tasks,
 	// then it is the time the task should be added to the
 	// dispatcher
 	boost::system_time m_expiration;
 	boost::function<void (void)> m_f;
+
+	// dispatcher queue link and the time the task was queued
+	Task* m_next;
+	int64_t m_enqueueTime;
+
+	friend class Dispatcher;
 };
 
 inline Task* createTask(boost::function<void (void)> f)
@@ -66,12 +79,24 @@ enum DispatcherState
 	STATE_TERMINATED
 };
 
+struct DispatcherStats
+{
+	uint64_t executed;
+	uint32_t queueDepth;
+	uint32_t maxQueueDepth;
+	// enqueue to execute latency in milliseconds
+	int64_t lastLatency;
+	int64_t maxLatency;
+	int64_t totalLatency;
+};
+
 class Dispatcher
 {
 public:
 	Dispatcher();
 
 	void addTask(Task* task, bool push_front = false);
+	DispatcherStats getStats();
 
 	void start();
 	void stop();
@@ -89,12 +114,29 @@ protected:
 	static void dispatcherThread(void* p);
 
 	void flush();
+	bool hasTasks() const;
+	// only called by the dispatcher thread
+	Task* popTask();
+	void executeTask(Task* task, DispatcherStats& stats);
+	void updateStats(const DispatcherStats& stats);
 
+	// only used to sleep when there is nothing to do
 	boost::mutex m_taskLock;
 	boost::condition_variable m_taskSignal;
-
-	std::list<Task*> m_taskList;
-	DispatcherState m_threadState;
+	boost::atomic<bool> m_sleeping;
+
+	// producers push onto these stacks, the dispatcher thread takes
+	// them as a whole and keeps the taken batch in FIFO order
+	boost::atomic<Task*> m_tasks;
+	boost::atomic<Task*> m_frontTasks;
+	boost::atomic<uint32_t> m_taskCount;
+	Task* m_batch;
+
+	DispatcherStats m_stats;
+	boost::atomic<DispatcherState> m_threadState;
+	// producers between their state check and their push, shutdown
+	// waits for them so no task is queued after the last flush
+	boost::atomic<uint32_t> m_addingTasks;
 };
 
 extern Dispatcher g_dispatcher;
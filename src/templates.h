@@ -24,15 +24,107 @@
 #include "definitions.h"
 #include "creature.h"
 #include <boost/thread.hpp>
-#include <set>
-#include <map>
+#include <vector>
+#include <deque>
+#include <iostream>
+#include <cstdlib>
+
+// Creature ids carry the AutoID slot in their low AUTOID_SLOT_BITS bits and
+// the slot generation right above it, the id range sits in the high bits.
+#define AUTOID_SLOT_BITS 18
+#define AUTOID_SLOT_MASK ((1 << AUTOID_SLOT_BITS) - 1)
+#define AUTOID_GENERATION_MASK 0x3FF
+// A freed slot is only handed out again once this many other slots are waiting,
+// so a stale id is not matched by a newly created creature any time soon.
+#define AUTOID_REUSE_DELAY 65536
+
+// Dense id -> pointer map. Entries live contiguously in a vector so iteration
+// is a linear scan, and a sparse table indexed by the id slot gives O(1) lookups.
+// Erasing moves the last entry into the hole, so it invalidates iterators.
+template<class T> class SlotMap
+{
+public:
+	typedef std::pair<uint32_t, T*> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin() {return dense.begin();}
+	iterator end() {return dense.end();}
+	const_iterator begin() const {return dense.begin();}
+	const_iterator end() const {return dense.end();}
+	size_t size() const {return dense.size();}
+	bool empty() const {return dense.empty();}
+
+	iterator find(uint32_t id)
+	{
+		uint32_t slot = id & AUTOID_SLOT_MASK;
+
+		if (slot < sparse.size() && sparse[slot] != 0)
+		{
+			iterator it = dense.begin() + (sparse[slot] - 1);
+
+			if (it->first == id)
+			{
+				return it;
+			}
+		}
+
+		return dense.end();
+	}
+
+	void insert(uint32_t id, T* t)
+	{
+		uint32_t slot = id & AUTOID_SLOT_MASK;
+
+		if (slot >= sparse.size())
+		{
+			sparse.resize(slot + 1, 0);
+		}
+
+		if (sparse[slot] != 0)
+		{
+			value_type& entry = dense[sparse[slot] - 1];
+			entry.first = id;
+			entry.second = t;
+			return;
+		}
+
+		dense.push_back(value_type(id, t));
+		sparse[slot] = (uint32_t)dense.size();
+	}
+
+	void erase(uint32_t id)
+	{
+		iterator it = find(id);
+
+		if (it == dense.end())
+		{
+			return;
+		}
+
+		uint32_t index = sparse[id & AUTOID_SLOT_MASK] - 1;
+		sparse[id & AUTOID_SLOT_MASK] = 0;
+
+		if (index != dense.size() - 1)
+		{
+			dense[index] = dense.back();
+			sparse[dense[index].first & AUTOID_SLOT_MASK] = index + 1;
+		}
+
+		dense.pop_back();
+	}
+
+protected:
+	std::vector<value_type> dense;
+	std::vector<uint32_t> sparse;
+};
 
 template<class T> class AutoList
 {
 public:
 	void addList(T* t)
 	{
-		list[t->getID()] = t;
+		list.insert(t->getID(), t);
 	}
 
 	void removeList(uint32_t _id)
@@ -40,7 +132,7 @@ public:
 		list.erase(_id);
 	}
 
-	typedef std::map<uint32_t, T*> list_type;
+	typedef SlotMap<T> list_type;
 	list_type list;
 
 	typedef typename list_type::iterator listiterator;
@@ -52,47 +144,48 @@ public:
 	AutoID()
 	{
 		boost::recursive_mutex::scoped_lock lockClass(autoIDLock);
-		count++;
-
-		if (count >= 0xFFFFFF)
-		{
-			count = 1000;
-		}
+		uint32_t slot;
 
-		while (list.find(count) != list.end())
+		if (freeSlots.size() >= AUTOID_REUSE_DELAY || generations.size() > AUTOID_SLOT_MASK)
 		{
-			if (count >= 0xFFFFFF)
+			if (freeSlots.empty())
 			{
-				count = 1000;
+				// every slot the id layout has room for belongs to a live creature
+				std::cout << "Error: [AutoID::AutoID] No creature id left." << std::endl;
+				std::abort();
 			}
-			else
+
+			slot = freeSlots.front();
+			freeSlots.pop_front();
+		}
+		else
+		{
+			//slot 0 is never used so no creature gets an auto_id of 0
+			if (generations.empty())
 			{
-				count++;
+				generations.push_back(0);
 			}
+
+			slot = (uint32_t)generations.size();
+			generations.push_back(0);
 		}
 
-		list.insert(count);
-		auto_id = count;
+		auto_id = (generations[slot] << AUTOID_SLOT_BITS) | slot;
 	}
 	virtual ~AutoID()
 	{
-		list_type::iterator it = list.find(auto_id);
-
-		if (it != list.end())
-		{
-			list.erase(it);
-		}
+		boost::recursive_mutex::scoped_lock lockClass(autoIDLock);
+		uint32_t slot = auto_id & AUTOID_SLOT_MASK;
+		generations[slot] = (generations[slot] + 1) & AUTOID_GENERATION_MASK;
+		freeSlots.push_back(slot);
 	}
 
-	typedef std::set<uint32_t> list_type;
-
 	uint32_t auto_id;
 	static boost::recursive_mutex autoIDLock;
 
 protected:
-	static uint32_t count;
-	static list_type list;
-
+	static std::vector<uint32_t> generations;
+	static std::deque<uint32_t> freeSlots;
 };
 
 #endif
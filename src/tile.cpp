@@ -183,6 +183,7 @@ uint32_t TileItemVector::getDownItemCount() const
 Tile::Tile(const uint16_t& x, const uint16_t& y, const uint16_t& z)
 	: qt_node(NULL)
 	, ground(NULL)
+	, packedItems(NULL)
 	, thingCount(0)
 	, tilePos(x, y, z)
 	, m_flags(0)
@@ -196,6 +197,21 @@ Tile::~Tile()
 
 bool Tile::hasProperty(enum ITEMPROPERTY prop, bool checkSolidForItems /* =false */) const
 {
+	// these are kept up to date in updateTileFlags
+	if (prop == BLOCKPROJECTILE)
+	{
+		return hasFlag(TILESTATE_BLOCKPROJECTILE);
+	}
+	else if (prop == BLOCKSOLID && !checkSolidForItems)
+	{
+		return hasFlag(TILESTATE_BLOCKSOLID);
+	}
+
+	if (packedItems)
+	{
+		return hasPackedProperty(prop, checkSolidForItems);
+	}
+
 	if (ground && ground->hasProperty(prop))
 	{
 		return true;
@@ -219,6 +235,12 @@ bool Tile::hasProperty(Item* exclude, enum ITEMPROPERTY prop) const
 {
 	assert(exclude);
 
+	if (packedItems)
+	{
+		// exclude is an Item object, so it can not be one of the packed items
+		return hasPackedProperty(prop, false);
+	}
+
 	if (ground && exclude != ground && ground->hasProperty(prop))
 	{
 		return true;
@@ -240,6 +262,26 @@ bool Tile::hasProperty(Item* exclude, enum ITEMPROPERTY prop) const
 	return false;
 }
 
+bool Tile::hasPackedProperty(ITEMPROPERTY prop, bool checkSolidForItems) const
+{
+	if (packedItems[0] && Item::hasProperty(Item::items[packedItems[0]], prop))
+	{
+		return true;
+	}
+
+	for (uint32_t i = 0; i < packedItems[1]; ++i)
+	{
+		const ItemType& it = Item::items[getPackedItemId(i)];
+
+		if (Item::hasProperty(it, prop) || (prop == BLOCKSOLID && checkSolidForItems && it.isSolidForItems()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool Tile::hasFlag(const tileflags_t& flag) const
 {
 	return ((m_flags & (uint32_t)flag) == flag);
@@ -352,6 +394,37 @@ bool Tile::hasHeight(const uint32_t& n) const
 {
 	uint32_t height = 0;
 
+	if (packedItems)
+	{
+		if (packedItems[0])
+		{
+			if (Item::items[packedItems[0]].hasHeight)
+			{
+				++height;
+			}
+
+			if (n == height)
+			{
+				return true;
+			}
+		}
+
+		for (uint32_t i = 0; i < packedItems[1]; ++i)
+		{
+			if (Item::items[getPackedItemId(i)].hasHeight)
+			{
+				++height;
+			}
+
+			if (n == height)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	if (ground)
 	{
 		if (ground->hasProperty(HASHEIGHT))
@@ -396,6 +469,11 @@ uint32_t Tile::getCreatureCount() const
 
 uint32_t Tile::getItemCount() const
 {
+	if (packedItems)
+	{
+		return packedItems[1];
+	}
+
 	if (const TileItemVector* items = getItemList())
 	{
 		return (uint32_t)items->size();
@@ -406,6 +484,11 @@ uint32_t Tile::getItemCount() const
 
 uint32_t Tile::getTopItemCount() const
 {
+	if (packedItems)
+	{
+		return packedItems[1] - packedItems[2];
+	}
+
 	if (const TileItemVector* items = getItemList())
 	{
 		return items->getTopItemCount();
@@ -416,6 +499,11 @@ uint32_t Tile::getTopItemCount() const
 
 uint32_t Tile::getDownItemCount() const
 {
+	if (packedItems)
+	{
+		return packedItems[2];
+	}
+
 	if (const TileItemVector* items = getItemList())
 	{
 		return items->getDownItemCount();
@@ -822,11 +910,11 @@ void Tile::moveCreature(Creature* creature, Cylinder* toCylinder, bool teleport
 	//remove the creature
 	__removeThing(creature, 0);
 
-	// Switch the node ownership
-	if (qt_node != newTile->qt_node)
+	// Switch the node ownership, creatures are kept per floor of the node
+	if (qt_node != newTile->qt_node || oldPos.z != newPos.z)
 	{
-		qt_node->removeCreature(creature);
-		newTile->qt_node->addCreature(creature);
+		qt_node->removeCreature(creature, oldPos.z);
+		newTile->qt_node->addCreature(creature, newPos.z);
 	}
 
 	//add the creature
@@ -880,7 +968,8 @@ ReturnValue Tile::__queryAdd(int32_t index, const Thing* thing, uint32_t count,
                              uint32_t flags) const
 {
 	const CreatureVector* creatures = getCreatures();
-	const TileItemVector* items = getItemList();
+	// creatures only need the item types, so packed items are left alone
+	const TileItemVector* items = (packedItems ? NULL : getItemList());
 
 	if (const Creature* creature = thing->getCreature())
 	{
@@ -897,7 +986,7 @@ ReturnValue Tile::__queryAdd(int32_t index, const Thing* thing, uint32_t count,
 			}
 		}
 
-		if (!ground)
+		if (!hasGround())
 		{
 			return RET_NOTPOSSIBLE;
 		}
@@ -1054,7 +1143,7 @@ ReturnValue Tile::__queryAdd(int32_t index, const Thing* thing, uint32_t count,
 			}
 		}
 
-		if (items)
+		if (items || packedItems)
 		{
 			MagicField* field = getFieldItem();
 
@@ -1074,7 +1163,7 @@ ReturnValue Tile::__queryAdd(int32_t index, const Thing* thing, uint32_t count,
 			else
 			{
 				//FLAG_IGNOREBLOCKITEM is set
-				if (ground)
+				if (getGround())
 				{
 					const ItemType& iiType = Item::items[ground->getID()];
 
@@ -1113,6 +1202,11 @@ ReturnValue Tile::__queryAdd(int32_t index, const Thing* thing, uint32_t count,
 
 #endif
 
+		if (packedItems)
+		{
+			items = getItemList();
+		}
+
 		if (items)
 		{
 			int64_t c = g_config.getNumber(ConfigManager::MAX_STACK_SIZE);
@@ -1554,7 +1648,7 @@ void Tile::__replaceThing(uint32_t index, Thing* thing)
 	Item* oldItem = NULL;
 	bool isInserted = false;
 
-	if (!isInserted && ground)
+	if (!isInserted && getGround())
 	{
 		if (pos == 0)
 		{
@@ -1803,7 +1897,7 @@ int32_t Tile::getClientIndexOfThing(const Player* player, const Thing* thing) co
 {
 	int n = -1;
 
-	if (ground)
+	if (hasGround())
 	{
 		if (ground == thing)
 		{
@@ -1813,26 +1907,24 @@ int32_t Tile::getClientIndexOfThing(const Player* player, const Thing* thing) co
 		++n;
 	}
 
-	const TileItemVector* items = getItemList();
+	// creatures only need the item counts, which packed items have too
+	const TileItemVector* items = (thing->getItem() ? getItemList() : NULL);
 
 	if (items)
 	{
-		if (thing->getItem())
+		for (ItemVector::const_iterator it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it)
 		{
-			for (ItemVector::const_iterator it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it)
-			{
-				++n;
+			++n;
 
-				if ((*it) == thing)
-				{
-					return n;
-				}
+			if ((*it) == thing)
+			{
+				return n;
 			}
 		}
-		else
-		{
-			n += items->getTopItemCount();
-		}
+	}
+	else
+	{
+		n += getTopItemCount();
 	}
 
 	if (const CreatureVector* creatures = getCreatures())
@@ -1853,22 +1945,15 @@ int32_t Tile::getClientIndexOfThing(const Player* player, const Thing* thing) co
 
 	if (items)
 	{
-		if (thing->getItem())
+		for (ItemVector::const_iterator it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it)
 		{
-			for (ItemVector::const_iterator it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it)
-			{
-				++n;
+			++n;
 
-				if ((*it) == thing)
-				{
-					return n;
-				}
+			if ((*it) == thing)
+			{
+				return n;
 			}
 		}
-		else
-		{
-			n += items->getDownItemCount();
-		}
 	}
 
 	return -1;
@@ -1878,7 +1963,7 @@ int32_t Tile::__getIndexOfThing(const Thing* thing) const
 {
 	int n = -1;
 
-	if (ground)
+	if (hasGround())
 	{
 		if (ground == thing)
 		{
@@ -1888,26 +1973,24 @@ int32_t Tile::__getIndexOfThing(const Thing* thing) const
 		++n;
 	}
 
-	const TileItemVector* items = getItemList();
+	// creatures only need the item counts, which packed items have too
+	const TileItemVector* items = (thing->getItem() ? getItemList() : NULL);
 
 	if (items)
 	{
-		if (thing->getItem())
+		for (ItemVector::const_iterator it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it)
 		{
-			for (ItemVector::const_iterator it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it)
-			{
-				++n;
+			++n;
 
-				if ((*it) == thing)
-				{
-					return n;
-				}
+			if ((*it) == thing)
+			{
+				return n;
 			}
 		}
-		else
-		{
-			n += items->getTopItemCount();
-		}
+	}
+	else
+	{
+		n += getTopItemCount();
 	}
 
 	if (const CreatureVector* creatures = getCreatures())
@@ -1925,22 +2008,15 @@ int32_t Tile::__getIndexOfThing(const Thing* thing) const
 
 	if (items)
 	{
-		if (thing->getItem())
+		for (ItemVector::const_iterator it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it)
 		{
-			for (ItemVector::const_iterator it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it)
-			{
-				++n;
+			++n;
 
-				if ((*it) == thing)
-				{
-					return n;
-				}
+			if ((*it) == thing)
+			{
+				return n;
 			}
 		}
-		else
-		{
-			n += items->getDownItemCount();
-		}
 	}
 
 	return -1;
@@ -1979,7 +2055,7 @@ uint32_t Tile::__getItemTypeCount(uint16_t itemId, int32_t subType /*= -1*/) con
 
 Thing* Tile::__getThing(uint32_t index) const
 {
-	if (ground)
+	if (getGround())
 	{
 		if (index == 0)
 		{
@@ -2299,6 +2375,11 @@ void Tile::updateTileFlags(Item* item, bool removed)
 			setFlag(TILESTATE_BLOCKSOLID);
 		}
 
+		if (item->hasProperty(BLOCKPROJECTILE))
+		{
+			setFlag(TILESTATE_BLOCKPROJECTILE);
+		}
+
 		if (item->getTeleport())
 		{
 			setFlag(TILESTATE_TELEPORT);
@@ -2366,6 +2447,11 @@ void Tile::updateTileFlags(Item* item, bool removed)
 			resetFlag(TILESTATE_BLOCKSOLID);
 		}
 
+		if (item->hasProperty(BLOCKPROJECTILE) && !hasProperty(item, BLOCKPROJECTILE))
+		{
+			resetFlag(TILESTATE_BLOCKPROJECTILE);
+		}
+
 		if (item->hasProperty(IMMOVABLEBLOCKSOLID) && !hasProperty(item, IMMOVABLEBLOCKSOLID))
 		{
 			resetFlag(TILESTATE_IMMOVABLEBLOCKSOLID);
@@ -2421,6 +2507,12 @@ void Tile::updateTileFlags(Item* item, bool removed)
 			resetFlag(TILESTATE_DEPOT);
 		}
 	}
+
+	// keep the bitmaps of the floor in sync, line of sight checks only read those
+	if (qt_node && qt_node->updateTileFlags(this))
+	{
+		g_game.clearSightCache();
+	}
 }
 
 bool Tile::is_dynamic() const
@@ -2430,7 +2522,7 @@ bool Tile::is_dynamic() const
 
 bool Tile::isMoveableBlocking() const
 {
-	if (!ground || hasFlag(TILESTATE_BLOCKSOLID))
+	if (!hasGround() || hasFlag(TILESTATE_BLOCKSOLID))
 	{
 		return true;
 	}
@@ -2438,6 +2530,100 @@ bool Tile::isMoveableBlocking() const
 	return false;
 }
 
+// Only plain items that carry nothing but their type can be packed
+static bool isPackableItem(const Item* item)
+{
+	const ItemType& it = Item::items[item->getID()];
+
+	if (item->hasAttributes() || it.stackable || it.isFluidContainer() || it.isSplash() || it.charges != 0)
+	{
+		return false;
+	}
+
+	if (it.decayTo != -1 && it.decayTime != 0)
+	{
+		return false;
+	}
+
+	return !it.isContainer() && !it.isDepot() && !it.isTeleport() && !it.isMagicField() && !it.isDoor() &&
+	       !it.isTrashHolder() && !it.isMailbox() && !it.isBed();
+}
+
+bool Tile::packItems()
+{
+	if (packedItems || isHouseTile() || hasFlag(TILESTATE_REFRESH) || getCreatureCount() != 0)
+	{
+		return false;
+	}
+
+	TileItemVector* items = getItemList();
+	uint32_t itemCount = (items ? items->size() : 0);
+
+	if ((!ground && itemCount == 0) || (ground && !isPackableItem(ground)))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < itemCount; ++i)
+	{
+		if (!isPackableItem(items->at(i)))
+		{
+			return false;
+		}
+	}
+
+	packedItems = new uint16_t[3 + itemCount];
+	packedItems[0] = (ground ? ground->getID() : 0);
+	packedItems[1] = itemCount;
+	packedItems[2] = (items ? items->downItemCount : 0);
+
+	for (uint32_t i = 0; i < itemCount; ++i)
+	{
+		packedItems[3 + i] = items->at(i)->getID();
+		delete items->at(i);
+	}
+
+	if (items)
+	{
+		ItemVector().swap(items->items);
+		items->downItemCount = 0;
+	}
+
+	delete ground;
+	ground = NULL;
+	return true;
+}
+
+void Tile::unpackItems() const
+{
+	// unpacking does not change what the tile holds, so const callers may do it
+	Tile* tile = const_cast<Tile*>(this);
+	uint16_t* ids = packedItems;
+	tile->packedItems = NULL;
+
+	if (ids[0])
+	{
+		tile->ground = Item::CreateItem(ids[0]);
+		tile->ground->setParent(tile);
+	}
+
+	if (ids[1] != 0)
+	{
+		TileItemVector* items = tile->makeItemList();
+
+		for (uint32_t i = 0; i < ids[1]; ++i)
+		{
+			Item* item = Item::CreateItem(ids[3 + i]);
+			item->setParent(tile);
+			items->push_back(item);
+		}
+
+		items->downItemCount = ids[2];
+	}
+
+	delete[] ids;
+}
+
 DynamicTile::DynamicTile(const uint16_t& x, const uint16_t& y, const uint16_t& z)
 	: Tile(x, y, z)
 {
@@ -73,7 +73,8 @@ uint32_t
 	TILESTATE_IMMOVABLEBLOCKPATH		= 1 << 22,
 	TILESTATE_IMMOVABLENOFIELDBLOCKPATH = 1 << 23,
 	TILESTATE_NOFIELDBLOCKPATH			= 1 << 24,
-	TILESTATE_DYNAMIC_TILE				= 1 << 25
+	TILESTATE_DYNAMIC_TILE				= 1 << 25,
+	TILESTATE_BLOCKPROJECTILE			= 1 << 26
 };
 
 enum ZoneType_t
@@ -193,6 +194,17 @@ public:
 	ZoneType_t getZone() const;
 
 	bool hasHeight(const uint32_t& n) const;
+
+	bool hasGround() const;
+	uint16_t getGroundId() const;
+	Item* getGround() const;
+
+	// Map items without attributes can be kept as their type ids only,
+	// the Item objects are created the first time the item list is used
+	bool packItems();
+	bool hasPackedItems() const;
+	uint16_t getPackedItemId(const uint32_t& index) const;
+
 	virtual std::string getDescription(const int32_t& lookDistance) const;
 
 	void moveCreature(Creature* creature, Cylinder* toCylinder, bool teleport = false);
@@ -239,15 +251,19 @@ private:
 	void onUpdateTile();
 
 	void updateTileFlags(Item* item, bool removed);
+	bool hasPackedProperty(ITEMPROPERTY prop, bool checkSolidForItems) const;
 
 protected:
 	bool is_dynamic() const;
+	void unpackItems() const;
 
 public:
 	QTreeLeafNode*	qt_node;
-	Item* ground;
 
 protected:
+	Item* ground;
+	// ground id, item count, down item count and the item ids in list order
+	uint16_t* packedItems;
 	uint32_t thingCount;
 	Position tilePos;
 	uint32_t m_flags;
@@ -327,6 +343,11 @@ inline CreatureVector* Tile::makeCreatures()
 
 inline TileItemVector* Tile::getItemList()
 {
+	if (packedItems)
+	{
+		unpackItems();
+	}
+
 	if (is_dynamic())
 	{
 		return static_cast<DynamicTile*>(this)->DynamicTile::getItemList();
@@ -337,6 +358,11 @@ inline TileItemVector* Tile::getItemList()
 
 inline const TileItemVector* Tile::getItemList() const
 {
+	if (packedItems)
+	{
+		unpackItems();
+	}
+
 	if (is_dynamic())
 	{
 		return static_cast<const DynamicTile*>(this)->DynamicTile::getItemList();
@@ -347,6 +373,11 @@ inline const TileItemVector* Tile::getItemList() const
 
 inline TileItemVector* Tile::makeItemList()
 {
+	if (packedItems)
+	{
+		unpackItems();
+	}
+
 	if (is_dynamic())
 	{
 		return static_cast<DynamicTile*>(this)->DynamicTile::makeItemList();
@@ -355,4 +386,39 @@ inline TileItemVector* Tile::makeItemList()
 	return static_cast<StaticTile*>(this)->StaticTile::makeItemList();
 }
 
+inline bool Tile::hasGround() const
+{
+	return ground || (packedItems && packedItems[0]);
+}
+
+inline uint16_t Tile::getGroundId() const
+{
+	if (packedItems)
+	{
+		return packedItems[0];
+	}
+
+	return ground ? ground->getID() : 0;
+}
+
+inline Item* Tile::getGround() const
+{
+	if (packedItems)
+	{
+		unpackItems();
+	}
+
+	return ground;
+}
+
+inline bool Tile::hasPackedItems() const
+{
+	return packedItems != NULL;
+}
+
+inline uint16_t Tile::getPackedItemId(const uint32_t& index) const
+{
+	return packedItems[3 + index];
+}
+
 #endif
@@ -1215,7 +1215,7 @@ bool WeaponDistance::useWeapon(Player* player, Item* item, Creature* target) con
 				tmpTile = g_game.getTile(destPos.x + it->first, destPos.y + it->second, destPos.z);
 
 				// Blocking tiles or tiles without ground ain't valid targets for spears
-				if (tmpTile && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && tmpTile->ground)
+				if (tmpTile && !tmpTile->hasProperty(IMMOVABLEBLOCKSOLID) && tmpTile->hasGround())
 				{
 					destTile = tmpTile;
 					break;